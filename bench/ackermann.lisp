@@ -0,0 +1,10 @@
+;; Ackermann function: very deep recursion with little work per call.
+;; ops: 81405 calls of ack
+(defun ack (m n)
+    (if (= m 0)
+        (+ n 1)
+        (if (= n 0)
+            (ack (- m 1) 1)
+            (ack (- m 1) (ack m (- n 1))))))
+
+(ack 2 200)
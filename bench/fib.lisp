@@ -0,0 +1,8 @@
+;; Doubly recursive Fibonacci: function calls and integer arithmetic.
+;; ops: 242785 calls of fib
+(defun fib (n)
+    (if (< n 2)
+        n
+        (+ (fib (- n 1)) (fib (- n 2)))))
+
+(fib 25)
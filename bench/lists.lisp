@@ -0,0 +1,14 @@
+;; List building: recursive consing through push, in-place growth through
+;; push!, and slicing the results back down.
+;; ops: 30000 elements built
+(defun build (n acc)
+    (if (= n 0) acc (build (- n 1) (push acc n))))
+
+(defun halve (xs)
+    (if (< (length xs) 2) xs (halve (slice xs 0 (/ (length xs) 2)))))
+
+(for round (range 0 10)
+    (define xs (build 1000 (list)))
+    (define ys (list))
+    (for i (range 0 2000) (push! ys i))
+    (halve ys))
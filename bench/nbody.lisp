@@ -0,0 +1,35 @@
+;; Planar n-body simulation of five bodies: floating point arithmetic and
+;; list indexing. Square roots are taken by Newton's method in the program.
+;; ops: 500 time steps
+(defun newton (x r k)
+    (if (= k 0) r (newton x (* 0.5 (+ r (/ x r))) (- k 1))))
+(defun sqrt (x) (newton x (if (> x 1.0) x 1.0) 20))
+
+(define xs (list 0.0 4.84 8.34 12.89 15.37))
+(define ys (list 0.0 -1.16 4.12 -15.11 -25.91))
+(define vxs (list 0.0 0.606 -1.01 1.08 0.979))
+(define vys (list 0.0 2.81 1.82 0.868 0.594))
+(define ms (list 39.47 0.037 0.011 0.0017 0.002))
+(define dt 0.01)
+
+(defun accelerate (i j)
+    (do
+        (define dx (- (index xs i) (index xs j)))
+        (define dy (- (index ys i) (index ys j)))
+        (define d2 (+ (* dx dx) (* dy dy)))
+        (define mag (/ dt (* d2 (sqrt d2))))
+        (set-index! vxs i (- (index vxs i) (* dx (index ms j) mag)))
+        (set-index! vys i (- (index vys i) (* dy (index ms j) mag)))
+        (set-index! vxs j (+ (index vxs j) (* dx (index ms i) mag)))
+        (set-index! vys j (+ (index vys j) (* dy (index ms i) mag)))))
+
+(defun advance ()
+    (do
+        (for i (range 0 5)
+            (for j (range (+ i 1) 5)
+                (accelerate i j)))
+        (for i (range 0 5)
+            (set-index! xs i (+ (index xs i) (* dt (index vxs i))))
+            (set-index! ys i (+ (index ys i) (* dt (index vys i)))))))
+
+(for step (range 0 500) (advance))
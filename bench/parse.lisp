@@ -0,0 +1,10 @@
+;; Parsing: reads a generated program of many small definitions and
+;; evaluates it, five times over.
+;; ops: 10000 definitions parsed
+(define source "@")
+(for i (range 0 2000)
+    (define source (replace source "@" (replace
+        "(defun fN (x y) (if (< x y) (+ x (* y N)) (- y (list x y 'quoted \"text\" 1.5))))\n@"
+        "N" (repr i)))))
+(for round (range 0 5)
+    (for form (parse source) (eval form)))
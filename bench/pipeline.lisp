@@ -0,0 +1,6 @@
+;; map/filter/reduce pipelines over ranges and materialised lists.
+;; ops: 400000 elements through a pipeline
+(define xs (map (lambda (x) (% (* x 7919) 1000)) (range 0 20000)))
+(for round (range 0 10)
+    (reduce + 0 (map (lambda (x) (* x x)) (filter (lambda (x) (= (% x 3) 0)) (range 0 20000))))
+    (reduce + 0 (filter (lambda (x) (> x 500)) (map (lambda (x) (+ x round)) xs))))
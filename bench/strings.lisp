@@ -0,0 +1,6 @@
+;; String building: repeated substitution into a growing string, with
+;; numbers rendered by repr.
+;; ops: 20000 appends
+(define text "@")
+(for i (range 0 20000)
+    (define text (replace text "@" (replace "N,@" "N" (repr i)))))
@@ -0,0 +1,483 @@
+// swzlisp-bench: runs the programs in bench/ under the interpreter and
+// reports wall time, throughput and peak memory as JSON.
+//
+//     swzlisp-bench [-n runs] [-w warmup] [-x interpreter] [-o out.json] [file.lisp ...]
+//     swzlisp-bench --compare base.json new.json [-t percent]
+//
+// Each program declares its unit of work on a comment line ";; ops: N what";
+// ops/sec is N over the median wall time. Peak RSS is the largest resident
+// set of any run, as reported by the kernel for the child process.
+#include<algorithm>
+#include<cctype>
+#include<cerrno>
+#include<chrono>
+#include<cstdlib>
+#include<cstring>
+#include<fstream>
+#include<iomanip>
+#include<iostream>
+#include<map>
+#include<memory>
+#include<sstream>
+#include<stdexcept>
+#include<string>
+#include<vector>
+#include<dirent.h>
+#include<fcntl.h>
+#include<sys/resource.h>
+#include<sys/wait.h>
+#include<unistd.h>
+
+#ifndef SWZLISP_BINARY
+#define SWZLISP_BINARY "swzlisp"
+#endif
+#ifndef SWZLISP_BENCH_DIR
+#define SWZLISP_BENCH_DIR "."
+#endif
+
+namespace{
+// -*-------------------------------------------------------------------*-
+// -*- Running                                                         -*-
+// -*-------------------------------------------------------------------*-
+struct Result{
+    std::string name;
+    std::string ops_unit;
+    double ops = 0;
+    std::vector<double> times;      // seconds, one per measured run
+    long peak_rss_kb = 0;
+    std::string error;
+};
+
+// -*-
+// Fraction q of the way through the sorted samples, interpolating
+// between neighbours.
+double quantile(std::vector<double> samples, double q){
+    if(samples.empty()){
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    double pos = q * (samples.size() - 1);
+    size_t lo = static_cast<size_t>(pos);
+    size_t hi = std::min(lo + 1, samples.size() - 1);
+    return samples[lo] + (pos - lo) * (samples[hi] - samples[lo]);
+}
+
+// -*-
+std::string basename(const std::string& path){
+    auto slash = path.find_last_of('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    auto dot = name.rfind(".lisp");
+    return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+// -*-
+// ";; ops: N unit" anywhere in the leading comment block
+void read_ops(const std::string& path, Result& result){
+    std::ifstream in(path);
+    std::string line;
+    while(std::getline(in, line) && line.rfind(";", 0) == 0){
+        auto pos = line.find("ops:");
+        if(pos == std::string::npos){
+            continue;
+        }
+        std::istringstream fields(line.substr(pos + 4));
+        fields >> result.ops;
+        std::getline(fields >> std::ws, result.ops_unit);
+    }
+}
+
+// -*-
+// One run of `interpreter -f path`: stdout is discarded and anything on
+// stderr counts as a failure, since the interpreter reports errors there
+// and still exits successfully.
+bool run_once(const std::string& interpreter, const std::string& path,
+              double& seconds, long& rss_kb, std::string& error)
+{
+    int errors[2];
+    if(pipe(errors) != 0){
+        error = std::strerror(errno);
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if(pid < 0){
+        error = std::strerror(errno);
+        close(errors[0]);
+        close(errors[1]);
+        return false;
+    }
+    if(pid == 0){
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        dup2(errors[1], STDERR_FILENO);
+        close(errors[0]);
+        execl(interpreter.c_str(), interpreter.c_str(), "-f", path.c_str(), static_cast<char*>(nullptr));
+        dprintf(STDERR_FILENO, "could not run '%s': %s\n", interpreter.c_str(), std::strerror(errno));
+        _exit(127);
+    }
+    close(errors[1]);
+    std::string output;
+    char buffer[512];
+    ssize_t count;
+    while((count = read(errors[0], buffer, sizeof(buffer))) > 0){
+        output.append(buffer, static_cast<size_t>(count));
+    }
+    close(errors[0]);
+
+    int status = 0;
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    rss_kb = usage.ru_maxrss;
+    if(!output.empty() || !WIFEXITED(status) || WEXITSTATUS(status) != 0){
+        error = output.empty() ? "exited abnormally" : output.substr(0, output.find('\n'));
+        return false;
+    }
+    return true;
+}
+
+// -*-
+Result measure(const std::string& interpreter, const std::string& path, int runs, int warmup){
+    Result result;
+    result.name = basename(path);
+    read_ops(path, result);
+    for(int i=0; i < warmup + runs; i++){
+        double seconds = 0;
+        long rss_kb = 0;
+        if(!run_once(interpreter, path, seconds, rss_kb, result.error)){
+            result.times.clear();
+            return result;
+        }
+        if(i >= warmup){
+            result.times.push_back(seconds);
+        }
+        result.peak_rss_kb = std::max(result.peak_rss_kb, rss_kb);
+    }
+    return result;
+}
+
+// -*-
+std::string escape(const std::string& text){
+    std::string result;
+    for(char c: text){
+        if(c == '"' || c == '\\'){
+            result += '\\';
+            result += c;
+        }else if(static_cast<unsigned char>(c) < 0x20){
+            result += ' ';
+        }else{
+            result += c;
+        }
+    }
+    return result;
+}
+
+// -*-
+void write_json(std::ostream& out, const std::string& interpreter, int runs,
+                const std::vector<Result>& results)
+{
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"interpreter\": \"" << escape(interpreter) << "\",\n";
+    out << "  \"runs\": " << runs << ",\n  \"benchmarks\": [";
+    for(size_t i=0; i < results.size(); i++){
+        const Result& result = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << escape(result.name) << "\"";
+        if(!result.error.empty()){
+            out << ", \"error\": \"" << escape(result.error) << "\"}";
+            continue;
+        }
+        double median = quantile(result.times, 0.5);
+        out << ", \"median_ms\": " << median*1e3;
+        out << ", \"p95_ms\": " << quantile(result.times, 0.95)*1e3;
+        out << ", \"min_ms\": " << quantile(result.times, 0.0)*1e3;
+        out << ", \"ops\": " << result.ops;
+        out << ", \"ops_unit\": \"" << escape(result.ops_unit) << "\"";
+        out << ", \"ops_per_sec\": " << (median > 0 ? result.ops/median : 0.0);
+        out << ", \"peak_rss_kb\": " << result.peak_rss_kb << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// -*-
+std::vector<std::string> default_programs(){
+    std::vector<std::string> result;
+    std::unique_ptr<DIR, int(*)(DIR*)> dir(opendir(SWZLISP_BENCH_DIR), closedir);
+    if(dir == nullptr){
+        return result;
+    }
+    while(dirent* entry = readdir(dir.get())){
+        std::string name = entry->d_name;
+        if(name.size() > 5 && name.compare(name.size() - 5, 5, ".lisp") == 0){
+            result.push_back(std::string(SWZLISP_BENCH_DIR) + "/" + name);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// -*-------------------------------------------------------------------*-
+// -*- Comparing                                                       -*-
+// -*-------------------------------------------------------------------*-
+// Just enough JSON to read back what write_json() produces: a value is a
+// number, a string, an array or an object.
+struct Value{
+    enum Kind{ Null, Number, String, Array, Object } kind = Null;
+    double number = 0;
+    std::string string;
+    std::vector<Value> items;
+    std::map<std::string, Value> fields;
+
+    const Value& operator[](const std::string& key) const{
+        static const Value none;
+        auto pos = this->fields.find(key);
+        return pos == this->fields.end() ? none : pos->second;
+    }
+};
+
+class Reader{
+public:
+    explicit Reader(const std::string& text): m_text{text}, m_pos{0}{}
+
+    Value parse(){
+        Value result = this->value();
+        this->skip();
+        if(this->m_pos != this->m_text.size()){
+            this->fail("trailing characters");
+        }
+        return result;
+    }
+
+private:
+    const std::string& m_text;
+    size_t m_pos;
+
+    [[noreturn]] void fail(const std::string& what){
+        throw std::runtime_error("invalid JSON at offset " + std::to_string(this->m_pos) + ": " + what);
+    }
+
+    void skip(){
+        while(this->m_pos < this->m_text.size() && std::isspace(static_cast<unsigned char>(this->m_text[this->m_pos]))){
+            this->m_pos++;
+        }
+    }
+
+    bool accept(char c){
+        this->skip();
+        if(this->m_pos < this->m_text.size() && this->m_text[this->m_pos] == c){
+            this->m_pos++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c){
+        if(!this->accept(c)){
+            this->fail(std::string("expected '") + c + "'");
+        }
+    }
+
+    std::string string(){
+        this->expect('"');
+        std::string result;
+        while(this->m_pos < this->m_text.size() && this->m_text[this->m_pos] != '"'){
+            if(this->m_text[this->m_pos] == '\\' && this->m_pos + 1 < this->m_text.size()){
+                this->m_pos++;
+            }
+            result += this->m_text[this->m_pos++];
+        }
+        this->expect('"');
+        return result;
+    }
+
+    Value value(){
+        Value result;
+        this->skip();
+        if(this->m_pos >= this->m_text.size()){
+            this->fail("unexpected end");
+        }
+        char c = this->m_text[this->m_pos];
+        if(c == '{'){
+            result.kind = Value::Object;
+            this->m_pos++;
+            if(!this->accept('}')){
+                do{
+                    std::string key = this->string();
+                    this->expect(':');
+                    result.fields[key] = this->value();
+                }while(this->accept(','));
+                this->expect('}');
+            }
+        }else if(c == '['){
+            result.kind = Value::Array;
+            this->m_pos++;
+            if(!this->accept(']')){
+                do{
+                    result.items.push_back(this->value());
+                }while(this->accept(','));
+                this->expect(']');
+            }
+        }else if(c == '"'){
+            result.kind = Value::String;
+            result.string = this->string();
+        }else{
+            const char* begin = this->m_text.c_str() + this->m_pos;
+            char* end = nullptr;
+            result.kind = Value::Number;
+            result.number = std::strtod(begin, &end);
+            if(end == begin){
+                this->fail("unexpected character");
+            }
+            this->m_pos += static_cast<size_t>(end - begin);
+        }
+        return result;
+    }
+};
+
+// -*-
+Value load(const std::string& filename){
+    std::ifstream in(filename);
+    if(!in.is_open()){
+        throw std::runtime_error("could not open file '" + filename + "'");
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+    std::string data = text.str();
+    return Reader(data).parse();
+}
+
+// -*-
+// Median time and peak RSS of each benchmark in both files; a benchmark
+// whose median grew by more than threshold percent is a regression, and
+// any regression makes the exit status 1.
+int compare(const std::string& base_file, const std::string& next_file, double threshold){
+    Value base = load(base_file);
+    Value next = load(next_file);
+    std::map<std::string, const Value*> before;
+    for(const auto& entry: base["benchmarks"].items){
+        before[entry["name"].string] = &entry;
+    }
+
+    int regressions = 0;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "-----------------------------------------------------------------------------\n";
+    std::cout << "   BENCHMARK |  BASE (ms) |   NEW (ms) |   CHANGE | BASE RSS (kB) | NEW RSS (kB)\n";
+    std::cout << "-----------------------------------------------------------------------------\n";
+    for(const auto& entry: next["benchmarks"].items){
+        const std::string& name = entry["name"].string;
+        auto pos = before.find(name);
+        std::cout << " " << std::setw(11) << name << " |";
+        if(pos == before.end() || entry["error"].kind != Value::Null || (*pos->second)["error"].kind != Value::Null){
+            std::cout << " (not comparable)\n";
+            continue;
+        }
+        const Value& old = *pos->second;
+        double t0 = old["median_ms"].number;
+        double t1 = entry["median_ms"].number;
+        double change = t0 > 0 ? (t1 - t0) / t0 * 100.0 : 0.0;
+        bool regressed = change > threshold;
+        regressions += regressed ? 1 : 0;
+        std::cout << " " << std::setw(10) << t0 << " |";
+        std::cout << " " << std::setw(10) << t1 << " |";
+        std::cout << " " << std::setw(7) << std::showpos << change << std::noshowpos << "% |";
+        std::cout << " " << std::setw(13) << static_cast<long>(old["peak_rss_kb"].number) << " |";
+        std::cout << " " << std::setw(12) << static_cast<long>(entry["peak_rss_kb"].number);
+        std::cout << (regressed ? "  REGRESSION\n" : "\n");
+    }
+    if(regressions > 0){
+        std::cout << regressions << " benchmark(s) slower by more than " << threshold << "%\n";
+    }
+    return regressions > 0 ? 1 : 0;
+}
+
+// -*-
+void usage(const char* progname){
+    std::cout << progname << " [-n runs] [-w warmup] [-x interpreter] [-o out.json] [file.lisp ...]\n";
+    std::cout << progname << " --compare base.json new.json [-t percent]\n\n";
+    std::cout << "Options:\n";
+    std::cout << "     -n runs          Measured runs per program (default 10)\n";
+    std::cout << "     -w warmup        Unmeasured runs first (default 1)\n";
+    std::cout << "     -x interpreter   Interpreter to run (default " << SWZLISP_BINARY << ")\n";
+    std::cout << "     -o out.json      Write the results there instead of stdout\n";
+    std::cout << "     -t percent       Slowdown reported as a regression (default 5)\n";
+    std::cout << "Without files, every program in " << SWZLISP_BENCH_DIR << " is run." << std::endl;
+}
+}
+
+// -*-------------------------------------------------------------------*-
+int main(int argc, char **argv){
+    int runs = 10;
+    int warmup = 1;
+    double threshold = 5.0;
+    std::string interpreter = SWZLISP_BINARY;
+    std::string output;
+    std::vector<std::string> files;
+    bool comparing = false;
+
+    try{
+        for(int i=1; i < argc; i++){
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if(arg == "-h" || arg == "--help"){
+                usage(argv[0]);
+                return EXIT_SUCCESS;
+            }else if(arg == "--compare"){
+                comparing = true;
+            }else if(arg == "-n" && has_value){
+                runs = std::max(1, std::atoi(argv[++i]));
+            }else if(arg == "-w" && has_value){
+                warmup = std::max(0, std::atoi(argv[++i]));
+            }else if(arg == "-x" && has_value){
+                interpreter = argv[++i];
+            }else if(arg == "-o" && has_value){
+                output = argv[++i];
+            }else if(arg == "-t" && has_value){
+                threshold = std::atof(argv[++i]);
+            }else if(!arg.empty() && arg[0] == '-'){
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }else{
+                files.push_back(arg);
+            }
+        }
+
+        if(comparing){
+            if(files.size() != 2){
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            return compare(files[0], files[1], threshold);
+        }
+
+        if(files.empty()){
+            files = default_programs();
+        }
+        std::vector<Result> results;
+        for(const auto& file: files){
+            results.push_back(measure(interpreter, file, runs, warmup));
+            const Result& result = results.back();
+            std::cerr << std::setw(12) << result.name << "  ";
+            if(result.error.empty()){
+                std::cerr << std::fixed << std::setprecision(1) << quantile(result.times, 0.5)*1e3 << " ms\n";
+            }else{
+                std::cerr << "FAILED: " << result.error << "\n";
+            }
+        }
+
+        if(output.empty()){
+            write_json(std::cout, interpreter, runs, results);
+        }else{
+            std::ofstream out(output);
+            if(!out.is_open()){
+                throw std::runtime_error("could not open file '" + output + "'");
+            }
+            write_json(out, interpreter, runs, results);
+        }
+        bool failed = std::any_of(results.begin(), results.end(), [](const Result& result){
+            return !result.error.empty();
+        });
+        return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    }catch(std::exception& err){
+        std::cerr << err.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
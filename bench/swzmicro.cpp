@@ -0,0 +1,219 @@
+// swzlisp-microbench: times the interpreter's core operations in process
+// and reports nanoseconds and heap allocations per operation.
+//
+//     swzlisp-microbench [filter]
+//
+// Only cases whose name contains filter are run. Allocations are counted
+// by replacing the global operator new, so they cover every heap block the
+// operation requests, whichever container asked for it.
+#include "swzlisp.hpp"
+#include<algorithm>
+#include<chrono>
+#include<cstdlib>
+#include<iomanip>
+#include<new>
+
+// -*-------------------------------------------------------------------*-
+// -*- Allocation counting                                             -*-
+// -*-------------------------------------------------------------------*-
+namespace{
+std::atomic<std::uint64_t> s_allocations{0};
+}
+
+void* operator new(std::size_t size){
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* ptr = std::malloc(size == 0 ? 1 : size)){
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size){
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept{
+    std::free(ptr);
+}
+
+namespace{
+using namespace swzlisp;
+
+// -*-------------------------------------------------------------------*-
+// -*- Harness                                                         -*-
+// -*-------------------------------------------------------------------*-
+typedef std::chrono::steady_clock Clock;
+
+// keeps a result alive so the timed work is not optimised away
+template<typename T>
+void keep(T&& value){
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+constexpr double BATCH_SECONDS = 0.05;
+constexpr int BATCHES = 7;
+
+// -*-
+// Doubles the batch size until a batch takes BATCH_SECONDS, then reports
+// the median over BATCHES batches; allocations are those of the last one.
+template<typename Op>
+void measure(const std::string& name, const std::string& filter, Op op){
+    if(name.find(filter) == std::string::npos){
+        return;
+    }
+    op();   // warm caches and lazily built state
+    size_t iterations = 1;
+    while(true){
+        auto start = Clock::now();
+        for(size_t i=0; i < iterations; i++){
+            op();
+        }
+        if(std::chrono::duration<double>(Clock::now() - start).count() >= BATCH_SECONDS || iterations >= (size_t(1) << 30)){
+            break;
+        }
+        iterations *= 2;
+    }
+    std::vector<double> times;
+    std::uint64_t allocations = 0;
+    for(int batch=0; batch < BATCHES; batch++){
+        std::uint64_t before = s_allocations.load(std::memory_order_relaxed);
+        auto start = Clock::now();
+        for(size_t i=0; i < iterations; i++){
+            op();
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        allocations = s_allocations.load(std::memory_order_relaxed) - before;
+        times.push_back(elapsed / iterations);
+    }
+    std::sort(times.begin(), times.end());
+    std::cout << " " << std::left << std::setw(28) << name << std::right << " |";
+    std::cout << " " << std::setw(14) << std::fixed << std::setprecision(1) << times[BATCHES/2] << " |";
+    std::cout << " " << std::setw(10) << std::setprecision(2) << static_cast<double>(allocations) / iterations << "\n";
+}
+
+// -*-
+// n top-level definitions of small functions, as a script would have them
+std::string program(size_t n){
+    std::ostringstream source;
+    for(size_t i=0; i < n; i++){
+        source << "(defun f" << i << " (x y) (if (< x y) (+ x (* y " << i << ")) \"text\"))\n";
+    }
+    return source.str();
+}
+
+// -*-
+Object numbers(size_t n){
+    std::vector<Object> items;
+    items.reserve(n);
+    for(size_t i=0; i < n; i++){
+        items.push_back(Object(static_cast<long>(i)));
+    }
+    return Object(items);
+}
+
+// -*-------------------------------------------------------------------*-
+// -*- Cases                                                           -*-
+// -*-------------------------------------------------------------------*-
+void parser_cases(const std::string& filter){
+    for(size_t n: {1, 100, 10000}){
+        std::string source = program(n);
+        measure("parse/" + std::to_string(n) + "-forms", filter, [&source]{
+            Parser parser(source);
+            keep(parser.parse());
+        });
+    }
+}
+
+// -*-
+// The name is bound in the outermost frame, so get() walks the whole chain.
+void env_cases(const std::string& filter){
+    for(size_t depth: {1, 8, 64}){
+        std::vector<std::shared_ptr<Env>> frames{std::make_shared<Env>(Runtime::builtins)};
+        frames.back()->put("target", Object(1L));
+        for(size_t i=1; i < depth; i++){
+            frames.push_back(std::make_shared<Env>());
+            frames.back()->put("local" + std::to_string(i), Object(static_cast<long>(i)));
+            frames.back()->set_parent(frames[i-1]);
+        }
+        const Env& innermost = *frames.back();
+        const std::string name = "target";
+        measure("env-get/depth-" + std::to_string(depth), filter, [&innermost, &name]{
+            keep(innermost.get(name));
+        });
+    }
+}
+
+// -*-
+void apply_cases(const std::string& filter){
+    Env env(Runtime::builtins);
+    const Object add = Runtime::builtins.get("+");
+    measure("apply/builtin", filter, [&add, &env]{
+        keep(add.apply({Object(1L), Object(2L)}, env));
+    });
+
+    Runtime::execute("(defun add2 (x y) (+ x y))", env);
+    const Object add2 = env.get("add2");
+    measure("apply/lambda", filter, [&add2, &env]{
+        keep(add2.apply({Object(1L), Object(2L)}, env));
+    });
+}
+
+// -*-
+void list_cases(const std::string& filter){
+    for(size_t n: {10, 1000}){
+        Object list = numbers(n);
+        measure("as-list/" + std::to_string(n), filter, [&list]{
+            keep(list.as_list());
+        });
+    }
+    Object list = numbers(1000);
+    measure("copy-object/list-1000", filter, [&list]{
+        Object copy(list);
+        keep(copy);
+    });
+}
+
+// -*-
+void print_cases(const std::string& filter){
+    Object list = numbers(10000);
+    measure("str/list-10000", filter, [&list]{
+        keep(list.str());
+    });
+    measure("repr/list-10000", filter, [&list]{
+        keep(list.repr());
+    });
+}
+}
+
+// -*-------------------------------------------------------------------*-
+int main(int argc, char **argv){
+    std::string filter = argc > 1 ? argv[1] : "";
+    Runtime::builtins = swzlisp_init();
+
+    std::cout << "------------------------------------------------------------\n";
+    std::cout << " CASE                         |        NS / OP |   ALLOCS / OP\n";
+    std::cout << "------------------------------------------------------------\n";
+    try{
+        parser_cases(filter);
+        env_cases(filter);
+        apply_cases(filter);
+        list_cases(filter);
+        print_cases(filter);
+    }catch(Error& err){
+        std::cerr << err.describe() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
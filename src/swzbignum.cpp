@@ -0,0 +1,427 @@
+#include "swzlisp.hpp"
+#include<algorithm>
+#include<iomanip>
+#include<cctype>
+
+// -*-------------------------------------------------------------------*-
+// -*- namespace::swzlisp                                              -*-
+// -*-------------------------------------------------------------------*-
+namespace swzlisp{
+// -*-------------------------------------------------------------------*-
+// -*- Bignum                                                          -*-
+// -*-------------------------------------------------------------------*-
+// Magnitudes are vectors of 32-bit limbs, least significant first, with no
+// leading zero limb. Zero is the empty vector and is never negative.
+namespace{
+typedef std::vector<std::uint32_t> Limbs;
+
+// Below this many limbs on the shorter operand, schoolbook wins.
+constexpr size_t KARATSUBA_THRESHOLD = 32;
+constexpr std::uint64_t BASE = std::uint64_t(1) << 32;
+
+// -*-
+void trim(Limbs& x){
+    while(!x.empty() && x.back() == 0){
+        x.pop_back();
+    }
+}
+
+// -*-
+int compare_magnitude(const Limbs& x, const Limbs& y){
+    if(x.size() != y.size()){
+        return x.size() < y.size() ? -1 : 1;
+    }
+    for(size_t i=x.size(); i > 0; i--){
+        if(x[i-1] != y[i-1]){
+            return x[i-1] < y[i-1] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// -*-
+Limbs add_magnitude(const Limbs& x, const Limbs& y){
+    const Limbs& big = x.size() >= y.size() ? x : y;
+    const Limbs& small = x.size() >= y.size() ? y : x;
+    Limbs result(big.size() + 1);
+    std::uint64_t carry = 0;
+    for(size_t i=0; i < big.size(); i++){
+        std::uint64_t sum = carry + big[i] + (i < small.size() ? small[i] : 0);
+        result[i] = static_cast<std::uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    result[big.size()] = static_cast<std::uint32_t>(carry);
+    trim(result);
+    return result;
+}
+
+// -*-
+// Requires |x| >= |y|.
+Limbs sub_magnitude(const Limbs& x, const Limbs& y){
+    Limbs result(x.size());
+    std::int64_t borrow = 0;
+    for(size_t i=0; i < x.size(); i++){
+        std::int64_t diff = static_cast<std::int64_t>(x[i]) - borrow;
+        diff -= (i < y.size() ? y[i] : 0);
+        borrow = diff < 0 ? 1 : 0;
+        result[i] = static_cast<std::uint32_t>(diff + (borrow ? BASE : 0));
+    }
+    trim(result);
+    return result;
+}
+
+// -*-
+// acc += x * BASE^shift
+void add_shifted(Limbs& acc, const Limbs& x, size_t shift){
+    if(acc.size() < x.size() + shift + 1){
+        acc.resize(x.size() + shift + 1, 0);
+    }
+    std::uint64_t carry = 0;
+    size_t i = 0;
+    for(; i < x.size(); i++){
+        std::uint64_t sum = carry + acc[i+shift] + x[i];
+        acc[i+shift] = static_cast<std::uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    for(i += shift; carry != 0; i++){
+        if(i == acc.size()){
+            acc.push_back(0);
+        }
+        std::uint64_t sum = carry + acc[i];
+        acc[i] = static_cast<std::uint32_t>(sum);
+        carry = sum >> 32;
+    }
+}
+
+// -*-
+Limbs mul_schoolbook(const Limbs& x, const Limbs& y){
+    if(x.empty() || y.empty()){
+        return Limbs();
+    }
+    Limbs result(x.size() + y.size(), 0);
+    for(size_t i=0; i < x.size(); i++){
+        std::uint64_t carry = 0;
+        for(size_t j=0; j < y.size(); j++){
+            std::uint64_t t = static_cast<std::uint64_t>(x[i]) * y[j];
+            t += result[i+j];
+            t += carry;
+            result[i+j] = static_cast<std::uint32_t>(t);
+            carry = t >> 32;
+        }
+        result[i+y.size()] = static_cast<std::uint32_t>(carry);
+    }
+    trim(result);
+    return result;
+}
+
+// -*-
+Limbs slice(const Limbs& x, size_t begin, size_t end){
+    begin = std::min(begin, x.size());
+    end = std::min(end, x.size());
+    Limbs result(x.begin() + begin, x.begin() + end);
+    trim(result);
+    return result;
+}
+
+// -*-
+// x*y = z2*B^2h + ((x0+x1)(y0+y1) - z2 - z0)*B^h + z0
+Limbs mul_magnitude(const Limbs& x, const Limbs& y){
+    const Limbs& big = x.size() >= y.size() ? x : y;
+    const Limbs& small = x.size() >= y.size() ? y : x;
+    if(small.size() < KARATSUBA_THRESHOLD){
+        return mul_schoolbook(big, small);
+    }
+    if(2*small.size() <= big.size()){
+        // Unbalanced: cut the long operand into pieces of the short one's size
+        Limbs result;
+        for(size_t i=0; i < big.size(); i += small.size()){
+            auto piece = slice(big, i, i + small.size());
+            add_shifted(result, mul_magnitude(piece, small), i);
+        }
+        trim(result);
+        return result;
+    }
+    size_t half = (big.size() + 1) / 2;
+    auto x0 = slice(x, 0, half);
+    auto x1 = slice(x, half, x.size());
+    auto y0 = slice(y, 0, half);
+    auto y1 = slice(y, half, y.size());
+    auto z0 = mul_magnitude(x0, y0);
+    auto z2 = mul_magnitude(x1, y1);
+    auto z1 = mul_magnitude(add_magnitude(x0, x1), add_magnitude(y0, y1));
+    z1 = sub_magnitude(sub_magnitude(z1, z0), z2);
+    Limbs result = z0;
+    add_shifted(result, z1, half);
+    add_shifted(result, z2, 2*half);
+    trim(result);
+    return result;
+}
+
+// -*-
+// Knuth's algorithm D (TAOCP 4.3.1) on 32-bit limbs.
+void divmod_magnitude(const Limbs& u, const Limbs& v, Limbs& q, Limbs& r){
+    if(compare_magnitude(u, v) < 0){
+        q.clear();
+        r = u;
+        return;
+    }
+    if(v.size() == 1){
+        std::uint64_t rem = 0;
+        q.assign(u.size(), 0);
+        for(size_t i=u.size(); i > 0; i--){
+            std::uint64_t cur = (rem << 32) | u[i-1];
+            q[i-1] = static_cast<std::uint32_t>(cur / v[0]);
+            rem = cur % v[0];
+        }
+        trim(q);
+        r.clear();
+        if(rem != 0){ r.push_back(static_cast<std::uint32_t>(rem)); }
+        return;
+    }
+
+    size_t n = v.size();
+    size_t m = u.size() - n;
+    int s = __builtin_clz(v[n-1]);
+    auto shl = [s](std::uint32_t hi, std::uint32_t lo) -> std::uint32_t {
+        return s == 0 ? hi : (hi << s) | (lo >> (32 - s));
+    };
+    Limbs vn(n), un(u.size() + 1);
+    for(size_t i=n-1; i > 0; i--){ vn[i] = shl(v[i], v[i-1]); }
+    vn[0] = v[0] << s;
+    un[m+n] = s == 0 ? 0 : u[m+n-1] >> (32 - s);
+    for(size_t i=m+n-1; i > 0; i--){ un[i] = shl(u[i], u[i-1]); }
+    un[0] = u[0] << s;
+
+    q.assign(m + 1, 0);
+    for(size_t k=m+1; k > 0; k--){
+        size_t j = k - 1;
+        std::uint64_t num = (static_cast<std::uint64_t>(un[j+n]) << 32) | un[j+n-1];
+        std::uint64_t qhat = num / vn[n-1];
+        std::uint64_t rhat = num % vn[n-1];
+        while(qhat >= BASE || qhat*vn[n-2] > ((rhat << 32) | un[j+n-2])){
+            qhat--;
+            rhat += vn[n-1];
+            if(rhat >= BASE){ break; }
+        }
+        // multiply and subtract
+        std::int64_t borrow = 0;
+        std::int64_t t = 0;
+        for(size_t i=0; i < n; i++){
+            std::uint64_t p = qhat * vn[i];
+            t = static_cast<std::int64_t>(un[i+j]) - borrow - static_cast<std::int64_t>(p & 0xFFFFFFFF);
+            un[i+j] = static_cast<std::uint32_t>(t);
+            borrow = static_cast<std::int64_t>(p >> 32) - (t >> 32);
+        }
+        t = static_cast<std::int64_t>(un[j+n]) - borrow;
+        un[j+n] = static_cast<std::uint32_t>(t);
+        q[j] = static_cast<std::uint32_t>(qhat);
+        if(t < 0){
+            // subtracted one time too many: add back
+            q[j]--;
+            std::uint64_t carry = 0;
+            for(size_t i=0; i < n; i++){
+                std::uint64_t sum = static_cast<std::uint64_t>(un[i+j]) + vn[i] + carry;
+                un[i+j] = static_cast<std::uint32_t>(sum);
+                carry = sum >> 32;
+            }
+            un[j+n] = static_cast<std::uint32_t>(un[j+n] + carry);
+        }
+    }
+    r.assign(n, 0);
+    for(size_t i=0; i < n; i++){
+        r[i] = s == 0 ? un[i] : (un[i] >> s) | (un[i+1] << (32 - s));
+    }
+    trim(q);
+    trim(r);
+}
+}
+
+// -*-
+Bignum::Bignum(): m_negative{false}{}
+
+// -*-
+Bignum::Bignum(long value): m_negative{value < 0}{
+    std::uint64_t mag = (
+        value < 0 ? -static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value)
+    );
+    while(mag != 0){
+        this->m_limbs.push_back(static_cast<std::uint32_t>(mag));
+        mag >>= 32;
+    }
+}
+
+// -*-
+Bignum Bignum::parse(const std::string& text){
+    size_t i = 0;
+    bool negative = false;
+    if(i < text.size() && (text[i] == '-' || text[i] == '+')){
+        negative = (text[i] == '-');
+        i++;
+    }
+    if(i == text.size()){
+        throw Error(Env(), ErrorKind::ValueError);
+    }
+    Bignum result;
+    const Limbs chunk_base = {1000000000};
+    while(i < text.size()){
+        // consume up to nine digits at a time
+        std::uint32_t chunk = 0;
+        std::uint32_t scale = 1;
+        for(size_t k=0; k < 9 && i < text.size(); k++, i++){
+            if(!std::isdigit(static_cast<unsigned char>(text[i]))){
+                throw Error(Env(), ErrorKind::ValueError);
+            }
+            chunk = chunk*10 + static_cast<std::uint32_t>(text[i] - '0');
+            scale *= 10;
+        }
+        result.m_limbs = mul_schoolbook(result.m_limbs, Limbs{scale});
+        result.m_limbs = add_magnitude(result.m_limbs, chunk ? Limbs{chunk} : Limbs{});
+    }
+    result.m_negative = negative && !result.m_limbs.empty();
+    return result;
+}
+
+// -*-
+bool Bignum::fits_long() const{
+    if(this->m_limbs.size() > 2){
+        return false;
+    }
+    std::uint64_t mag = this->magnitude();
+    std::uint64_t limit = static_cast<std::uint64_t>(std::numeric_limits<long>::max());
+    return this->m_negative ? mag <= limit + 1 : mag <= limit;
+}
+
+// -*-
+long Bignum::to_long() const{
+    std::uint64_t mag = this->magnitude();
+    return this->m_negative ? static_cast<long>(-mag) : static_cast<long>(mag);
+}
+
+// -*-
+double Bignum::to_double() const{
+    double result = 0.0;
+    for(size_t i=this->m_limbs.size(); i > 0; i--){
+        result = result * static_cast<double>(BASE) + this->m_limbs[i-1];
+    }
+    return this->m_negative ? -result : result;
+}
+
+// -*-
+std::string Bignum::str() const{
+    if(this->m_limbs.empty()){
+        return "0";
+    }
+    std::vector<std::uint32_t> chunks;
+    Limbs mag = this->m_limbs;
+    Limbs quotient, rem;
+    while(!mag.empty()){
+        divmod_magnitude(mag, Limbs{1000000000}, quotient, rem);
+        chunks.push_back(rem.empty() ? 0 : rem[0]);
+        mag.swap(quotient);
+    }
+    std::ostringstream stream;
+    if(this->m_negative){ stream << '-'; }
+    stream << chunks.back();
+    for(size_t i=chunks.size()-1; i > 0; i--){
+        stream << std::setw(9) << std::setfill('0') << chunks[i-1];
+    }
+    return stream.str();
+}
+
+// -*-
+size_t Bignum::hash() const{
+    size_t result = this->m_negative ? 0x9e3779b97f4a7c15ull : 0;
+    for(auto limb: this->m_limbs){
+        result ^= limb + 0x9e3779b97f4a7c15ull + (result << 6) + (result >> 2);
+    }
+    return result;
+}
+
+// -*-
+int Bignum::compare(const Bignum& other) const{
+    if(this->m_negative != other.m_negative){
+        return this->m_negative ? -1 : 1;
+    }
+    int result = compare_magnitude(this->m_limbs, other.m_limbs);
+    return this->m_negative ? -result : result;
+}
+
+// -*-
+Bignum Bignum::operator-() const{
+    Bignum result = *this;
+    result.m_negative = !this->m_negative && !this->m_limbs.empty();
+    return result;
+}
+
+// -*-
+Bignum Bignum::operator+(const Bignum& other) const{
+    Bignum result;
+    if(this->m_negative == other.m_negative){
+        result.m_limbs = add_magnitude(this->m_limbs, other.m_limbs);
+        result.m_negative = this->m_negative;
+    }else if(compare_magnitude(this->m_limbs, other.m_limbs) >= 0){
+        result.m_limbs = sub_magnitude(this->m_limbs, other.m_limbs);
+        result.m_negative = this->m_negative;
+    }else{
+        result.m_limbs = sub_magnitude(other.m_limbs, this->m_limbs);
+        result.m_negative = other.m_negative;
+    }
+    result.m_negative = result.m_negative && !result.m_limbs.empty();
+    return result;
+}
+
+// -*-
+Bignum Bignum::operator-(const Bignum& other) const{
+    return *this + (-other);
+}
+
+// -*-
+Bignum Bignum::operator*(const Bignum& other) const{
+    Bignum result;
+    result.m_limbs = mul_magnitude(this->m_limbs, other.m_limbs);
+    result.m_negative = (
+        (this->m_negative != other.m_negative) && !result.m_limbs.empty()
+    );
+    return result;
+}
+
+// -*-
+// Truncating division, like the fixnum '/': the quotient rounds toward
+// zero and the remainder takes the sign of the dividend.
+Bignum Bignum::operator/(const Bignum& other) const{
+    if(other.m_limbs.empty()){
+        throw Error(Env(), ErrorKind::ZeroDivisionError);
+    }
+    Bignum quotient;
+    Limbs rem;
+    divmod_magnitude(this->m_limbs, other.m_limbs, quotient.m_limbs, rem);
+    quotient.m_negative = (
+        (this->m_negative != other.m_negative) && !quotient.m_limbs.empty()
+    );
+    return quotient;
+}
+
+// -*-
+Bignum Bignum::operator%(const Bignum& other) const{
+    if(other.m_limbs.empty()){
+        throw Error(Env(), ErrorKind::ZeroDivisionError);
+    }
+    Bignum rem;
+    Limbs quotient;
+    divmod_magnitude(this->m_limbs, other.m_limbs, quotient, rem.m_limbs);
+    rem.m_negative = this->m_negative && !rem.m_limbs.empty();
+    return rem;
+}
+
+// -*-
+std::uint64_t Bignum::magnitude() const{
+    std::uint64_t mag = 0;
+    for(size_t i=this->m_limbs.size(); i > 0; i--){
+        mag = (mag << 32) | this->m_limbs[i-1];
+    }
+    return mag;
+}
+
+// -*-------------------------------------------------------------------*-
+}//-*- end::namespace::swzlisp                                         -*-
+// -*-------------------------------------------------------------------*-
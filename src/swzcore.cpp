@@ -1,5 +1,12 @@
 #include "swzlisp.hpp"
 #include<iomanip>
+#include<cstring>
+#include<algorithm>
+#include<array>
+#include<chrono>
+#include<sys/resource.h>
+#include<pthread.h>
+#include<unistd.h>
 
 // -*-------------------------------------------------------------------*-
 // -*- namespace::swzlisp                                              -*-
@@ -17,28 +24,34 @@ Object::Object(long val): m_type{Type::Integer}, m_value{val}{}
 Object::Object(double val): m_type{Type::Float}, m_value{val}{}
 
 // -*-
-Object::Object(std::vector<Object> list): m_type{Type::List}, m_value{list}{}
+Object::Object(std::vector<Object> list)
+: m_type{Type::List}, m_value{make_slice(std::move(list))}{}
+
+// -*-
+Object::Slice Object::make_slice(List items){
+    Accounting::record(Accounting::ListAlloc);
+    size_t length = items.size();
+    return Slice{std::make_shared<List>(std::move(items)), 0, length};
+}
 
 // -*-
 Object::Object(std::vector<Object> params, Object body, const Env& env)
 : m_type{Type::Lambda}{
-    std::vector<Object> self;
-    self.push_back(Object(params));
-    Lambda lambda;
-    lambda.params = params;
-    lambda.body = std::make_shared<Object>(body);
+    auto lambda = std::make_shared<Lambda>();
+    lambda->params = params;
+    lambda->body = std::make_shared<Object>(body);
     for(auto name: body.atoms()){
         if(env.contains(name)){
             auto val = env.get(name);
-            lambda.env.put(name, val);
+            lambda->env.put(name, val);
         }
     }
-    this->m_value = lambda;
+    this->m_value = Closure(lambda);
 }
 
 // -*-
 Object::Object(std::string name, Fun fun): m_type{Type::Builtin}{
-    Builtin builtin = {name, fun};
+    Builtin builtin = {name, fun, intern_name(name)};
     this->m_value = builtin;
 }
 
@@ -48,7 +61,118 @@ Object Object::create_quote(Object obj){
     self.m_type = Type::Quote;
     std::vector<Object> vec;
     vec.push_back(obj);
-    self.m_value = vec;
+    self.m_value = make_slice(std::move(vec));
+    return self;
+}
+
+// -*-
+// Integers are kept as fixnums whenever they fit in a long.
+Object Object::create_integer(const Bignum& value){
+    if(value.fits_long()){
+        return Object(value.to_long());
+    }
+    Object self;
+    self.m_type = Type::Bignum;
+    self.m_value = std::make_shared<const Bignum>(value);
+    return self;
+}
+
+// -*-
+Object Object::create_f64vec(std::vector<double> data){
+    Object self;
+    self.m_type = Type::F64Vec;
+    self.m_value = std::make_shared<const std::vector<double>>(std::move(data));
+    return self;
+}
+
+// -*-
+Object Object::create_i64vec(std::vector<long> data){
+    Object self;
+    self.m_type = Type::I64Vec;
+    self.m_value = std::make_shared<const std::vector<long>>(std::move(data));
+    return self;
+}
+
+// -*-
+Object Object::create_hashmap(){
+    Object self;
+    self.m_type = Type::HashMap;
+    self.m_value = std::make_shared<HashMap>();
+    return self;
+}
+
+// -*-
+Object Object::create_transient(std::vector<Object> items){
+    Object self;
+    self.m_type = Type::Transient;
+    auto transient = std::make_shared<Transient>();
+    transient->items = std::move(items);
+    self.m_value = transient;
+    return self;
+}
+
+// -*-
+Object Object::create_macro(std::vector<Object> params, Object body, const Env& env){
+    Object self(std::move(params), std::move(body), env);
+    self.m_type = Type::Macro;
+    return self;
+}
+
+// -*-
+// A copy of this function whose results are cached by argument list.
+Object Object::memoize(size_t capacity) const{
+    if(this->m_type != Type::Lambda){
+        throw Error(Env(), "memoize: expected a lambda");
+    }
+    auto lambda = std::make_shared<Lambda>(*std::get<Closure>(this->m_value));
+    lambda->memo = std::make_shared<MemoCache>(capacity);
+    Object self(*this);
+    self.m_value = Closure(lambda);
+    return self;
+}
+
+// -*-
+// A copy of this function that reports itself under name in profiles.
+Object Object::named(const std::string& name) const{
+    if(this->m_type != Type::Lambda && this->m_type != Type::Macro){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    auto lambda = std::make_shared<Lambda>(*std::get<Closure>(this->m_value));
+    lambda->name = intern_name(name);
+    Object self(*this);
+    self.m_value = Closure(lambda);
+    return self;
+}
+
+// -*-
+std::shared_ptr<MemoCache> Object::memo_cache() const{
+    if(this->m_type != Type::Lambda){
+        return nullptr;
+    }
+    return std::get<Closure>(this->m_value)->memo;
+}
+
+// -*-
+Object Object::create_sequence(std::shared_ptr<const Sequence> seq){
+    Object self;
+    self.m_type = Type::Sequence;
+    self.m_value = std::move(seq);
+    return self;
+}
+
+// -*-
+Object Object::create_pvec(const PersistentVector& data){
+    Object self;
+    self.m_type = Type::PVec;
+    self.m_value = std::make_shared<const PersistentVector>(data);
+    return self;
+}
+
+// -*-
+Object Object::create_pmap(const PersistentMap& data){
+    Object self;
+    self.m_type = Type::PMap;
+    self.m_value = std::make_shared<const PersistentMap>(data);
     return self;
 }
 
@@ -56,13 +180,16 @@ Object Object::create_quote(Object obj){
 Object Object::create_atom(std::string str){
     Object self;
     self.m_type = Type::Atom;
-    self.m_value = str;
+    auto cache = std::make_shared<InlineCache>();
+    cache->bits = Env::name_bits(str);
+    self.m_value = Symbol{str, cache};
     return self;
 }
 
 // -*-
 Object Object::create_string(std::string str){
     Object self;
+    Accounting::record(Accounting::StringAlloc);
     self.m_type = Type::String;
     self.m_value = str;
     return self;
@@ -83,8 +210,8 @@ std::vector<std::string> Object::atoms(){
         result = items[0].atoms();
         break;
     case Type::Lambda:
-        this->unwrap(items);
-        result = items[1].atoms();
+    case Type::Macro:
+        result = std::get<Closure>(this->m_value)->body->atoms();
         break;
     case Type::List:
         this->unwrap(items);
@@ -104,42 +231,337 @@ bool Object::is_builtin() const{
     return this->m_type == Type::Builtin;
 }
 
+namespace{
+// -*-
+// Execution limits are checked once per window of evaluations: eval() only
+// counts the window down, and the clock and resident set are read when it
+// runs out. Without limits the window never does.
+constexpr std::uint64_t UNLIMITED = std::numeric_limits<std::uint64_t>::max();
+constexpr std::uint64_t CHECK_INTERVAL = 1024;
+
+struct Meter{
+    std::uint64_t countdown = UNLIMITED;    // evaluations left in the window
+    std::uint64_t window = UNLIMITED;       // evaluations the window began with
+    std::uint64_t spent = 0;                // evaluations before the window
+    std::uint64_t fuel_end = UNLIMITED;     // spent at which fuel runs out
+    std::uint64_t deadline = 0;             // steady clock, ns; 0 for none
+    size_t memory_end = 0;                  // resident bytes; 0 for none
+
+    void sync(){
+        if(this->window != UNLIMITED){
+            this->spent += this->window - this->countdown;
+        }
+        this->window = this->countdown;
+    }
+
+    void rearm(){
+        if(this->fuel_end == UNLIMITED && this->deadline == 0 && this->memory_end == 0){
+            this->window = UNLIMITED;
+        }else if(this->spent >= this->fuel_end){
+            this->window = 1;
+        }else{
+            this->window = std::min(CHECK_INTERVAL, this->fuel_end - this->spent);
+        }
+        this->countdown = this->window;
+    }
+
+    void check(const Env& env);
+};
+
+// -*-
+// Evaluation depth on this thread. The outermost eval records where the
+// native stack stood; nested evals fail with a RuntimeError once the stack
+// has grown past its budget, and lambda calls are counted against
+// Runtime::recursion_limit, so runaway recursion is reported instead of
+// overflowing the stack. The execution meter rides along.
+struct EvalStack{
+    size_t depth = 0;
+    size_t calls = 0;
+    std::uintptr_t base = 0;
+    size_t budget = 0;
+    Meter meter;
+};
+thread_local EvalStack s_stack;
+
+// -*-
+std::uint64_t clock_ns(){
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count());
+}
+
+// -*-
+// resident set of the process in bytes, 0 where it cannot be read
+size_t resident_bytes(){
+    long pages = 0;
+    std::ifstream statm("/proc/self/statm");
+    if(!(statm >> pages >> pages)){
+        return 0;
+    }
+    return static_cast<size_t>(pages) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// -*-
+// The window has run out. A limit that has been reached raises and leaves
+// a window of one, so the next evaluation raises again.
+void Meter::check(const Env& env){
+    this->spent += this->window;
+    this->window = this->countdown = 1;
+    if(this->spent >= this->fuel_end){
+        throw Error(env, "execution limit exceeded: out of fuel");
+    }
+    if(this->deadline != 0 && clock_ns() >= this->deadline){
+        throw Error(env, "execution limit exceeded: deadline passed");
+    }
+    if(this->memory_end != 0 && resident_bytes() > this->memory_end){
+        throw Error(env, "execution limit exceeded: memory cap reached");
+    }
+    this->rearm();
+}
+
+// -*-
+// size of this thread's stack, less a margin for the builtins and library
+// code that run between two checks
+size_t stack_budget(){
+    size_t size = size_t(8) << 20;
+#if defined(__GLIBC__)
+    pthread_attr_t attr;
+    if(pthread_getattr_np(pthread_self(), &attr) == 0){
+        void* addr = nullptr;
+        size_t stacksize = 0;
+        if(pthread_attr_getstack(&attr, &addr, &stacksize) == 0 && stacksize > 0){
+            size = stacksize;
+        }
+        pthread_attr_destroy(&attr);
+    }
+#else
+    rlimit limit;
+    if(getrlimit(RLIMIT_STACK, &limit)==0 && limit.rlim_cur != RLIM_INFINITY){
+        size = static_cast<size_t>(limit.rlim_cur);
+    }
+#endif
+    return size - size/8;
+}
+
+class EvalGuard{
+public:
+    explicit EvalGuard(const Env& env){
+        if(__builtin_expect(--s_stack.meter.countdown == 0, false)){
+            s_stack.meter.check(env);
+        }
+        char marker;
+        auto here = reinterpret_cast<std::uintptr_t>(&marker);
+        if(s_stack.depth == 0){
+            s_stack.base = here;
+            if(s_stack.budget == 0){
+                s_stack.budget = stack_budget();
+            }
+        }else if(s_stack.base > here && s_stack.base - here > s_stack.budget){
+            throw Error(env, "maximum recursion depth exceeded (stack exhausted)");
+        }
+        s_stack.depth++;
+    }
+    ~EvalGuard(){ s_stack.depth--; }
+};
+
+class CallGuard{
+public:
+    explicit CallGuard(const Env& env){
+        if(s_stack.calls >= Runtime::recursion_limit){
+            throw Error(env, "maximum recursion depth exceeded");
+        }
+        s_stack.calls++;
+    }
+    ~CallGuard(){ s_stack.calls--; }
+};
+
+// -*-
+// Keeps CallStack, and Stats when enabled, in step with apply(), exceptions
+// included. A frame entered while Stats was off is never timed.
+class StackFrame{
+public:
+    explicit StackFrame(FrameName name): m_name{name}, m_timed{Stats::enabled()}{
+        CallStack::push(name);
+        if(this->m_timed){
+            Stats::enter();
+        }
+    }
+    ~StackFrame(){
+        if(this->m_timed){
+            Stats::leave(this->m_name);
+        }
+        CallStack::pop();
+    }
+
+private:
+    FrameName m_name;
+    bool m_timed;
+};
+
+FrameName anonymous(){
+    static const FrameName name = intern_name("lambda");
+    return name;
+}
+
+// -*-
+// Adaptive dispatch of calls to builtins. A site counts its executions
+// while Cold; once hot it specialises when it calls one of these builtins
+// with two arguments, and settles on the generic path otherwise. A site
+// whose guards miss MAX_MISSES times goes generic for good.
+constexpr std::uint16_t HOT = 32;
+constexpr std::uint8_t MAX_MISSES = 8;
+
+struct Specialization{
+    const char* name;
+    InlineCache::Path path;
+};
+
+const Specialization specializations[] = {
+    {"+", InlineCache::Add}, {"-", InlineCache::Sub}, {"*", InlineCache::Mul},
+    {"<", InlineCache::Less}, {">", InlineCache::Greater},
+    {"<=", InlineCache::LessEqual}, {">=", InlineCache::GreaterEqual},
+    {"=", InlineCache::Equal},
+};
+
+// interned name of the builtin a specialised path stands for
+FrameName specialized_name(InlineCache::Path path){
+    static const auto names = []{
+        std::array<FrameName, InlineCache::Equal + 1> result{};
+        for(const auto& item: specializations){
+            result[item.path] = intern_name(item.name);
+        }
+        return result;
+    }();
+    return names[path];
+}
+
+void deoptimize(InlineCache& site){
+    if(++site.misses >= MAX_MISSES){
+        site.path = InlineCache::Generic;
+    }
+}
+
+// the builtin's own semantics, on operands already evaluated
+Object generic(InlineCache::Path path, Object x, Object y){
+    switch(path){
+    case InlineCache::Add:
+        return Object::sum({std::move(x), std::move(y)});
+    case InlineCache::Sub:
+        return Object::difference({std::move(x), std::move(y)});
+    case InlineCache::Mul:
+        return Object::product({std::move(x), std::move(y)});
+    case InlineCache::Less:
+        return Object(static_cast<long>(x < y));
+    case InlineCache::Greater:
+        return Object(static_cast<long>(x > y));
+    case InlineCache::LessEqual:
+        return Object(static_cast<long>(x <= y));
+    case InlineCache::GreaterEqual:
+        return Object(static_cast<long>(x >= y));
+    default:
+        return Object(static_cast<long>(x == y));
+    }
+}
+}
+
+// -*-
+Budget::Budget(const Limits& limits){
+    s_stack.meter.sync();
+    this->m_fuel_end = s_stack.meter.fuel_end;
+    this->m_deadline = s_stack.meter.deadline;
+    this->m_memory_end = s_stack.meter.memory_end;
+    if(limits.fuel != 0 && limits.fuel < s_stack.meter.fuel_end - s_stack.meter.spent){
+        s_stack.meter.fuel_end = s_stack.meter.spent + limits.fuel;
+    }
+    if(limits.seconds > 0){
+        auto deadline = clock_ns() + static_cast<std::uint64_t>(limits.seconds * 1e9);
+        if(s_stack.meter.deadline == 0 || deadline < s_stack.meter.deadline){
+            s_stack.meter.deadline = deadline;
+        }
+    }
+    if(limits.memory != 0){
+        size_t memory_end = resident_bytes() + limits.memory;
+        if(s_stack.meter.memory_end == 0 || memory_end < s_stack.meter.memory_end){
+            s_stack.meter.memory_end = memory_end;
+        }
+    }
+    s_stack.meter.rearm();
+}
+
 // -*-
-Object Object::apply(std::vector<Object> args, Env& env){
-    Env scope;
+Budget::~Budget(){
+    s_stack.meter.sync();
+    s_stack.meter.fuel_end = this->m_fuel_end;
+    s_stack.meter.deadline = this->m_deadline;
+    s_stack.meter.memory_end = this->m_memory_end;
+    s_stack.meter.rearm();
+}
+
+// -*-
+Object Object::apply(std::vector<Object> args, Env& env) const {
     Object result;
-    List params;
     switch(this->m_type){
-    case Type::Lambda:{
-            Lambda lambda;
-            unwrap(lambda);
-            params = lambda.params;
-            if(params.size() != args.size()){
+    case Type::Lambda:
+    case Type::Macro:{
+            // Hold the closure: the binding that produced it may be
+            // redefined while the body runs.
+            Closure closure = std::get<Closure>(this->m_value);
+            Env frame(closure->env);
+            const List& params = closure->params;
+            // a trailing `&rest name` collects the remaining arguments
+            size_t fixed = params.size();
+            bool rest = (
+                fixed >= 2 && params[fixed-2].m_type==Type::Atom &&
+                std::get<Symbol>(params[fixed-2].m_value).name == "&rest"
+            );
+            if(rest){
+                fixed -= 2;
+            }
+            if(rest ? args.size() < fixed : args.size() != fixed){
                 std::string msg = (
-                    args.size() > params.size() ?
-                    "No enough arguments" : "Too many arguments"
+                    args.size() > fixed ?
+                    "Too many arguments" : "No enough arguments"
                 );
                 msg = swzlispExceptions[ErrorKind::SyntaxError] + ": " + msg;
                 //auto xxx = *this;
                 throw Error(env, msg.c_str());
             }
-            lambda.env.set_parent(env.get_pointer());
+            if(closure->memo){
+                if(const Object* hit = closure->memo->find(args)){
+                    result = *hit;
+                    break;
+                }
+            }
+            CallGuard guard(env);
+            StackFrame trace(closure->name ? closure->name : anonymous());
+            TraceScope scope(
+                closure->name ? closure->name : anonymous(),
+                this->m_type==Type::Macro ? "macro" : "function", Span(), true);
+            frame.set_caller(env.get_pointer());
             for(size_t i=0; i < params.size(); i++){
                 if(params[i].m_type!=Type::Atom){
                     throw Error(env, ErrorKind::RuntimError);
                 }
-                Object obj = params[i];
-                std::string name;
-                obj.unwrap(name);
-                lambda.env.put(name, args[i]);
             }
-            result = lambda.body->eval(lambda.env);
+            for(size_t i=0; i < fixed; i++){
+                frame.put(std::get<Symbol>(params[i].m_value).name, args[i]);
+            }
+            if(rest){
+                frame.put(
+                    std::get<Symbol>(params[fixed+1].m_value).name,
+                    Object(List(args.begin()+fixed, args.end()))
+                );
+            }
+            result = closure->body->eval(frame);
+            if(closure->memo){
+                closure->memo->insert(args, result);
+            }
         }//
         break;
     case Type::Builtin:{
-            Builtin builtin;
-            unwrap(builtin);
-            result = builtin.fun(args, env);
+            const Builtin& builtin = std::get<Builtin>(this->m_value);
+            StackFrame trace(builtin.frame);
+            result = builtin.fun(std::move(args), env);
         }//
         break;
     default:{
@@ -154,166 +576,811 @@ Object Object::apply(std::vector<Object> args, Env& env){
 }
 
 // -*-
-Object Object::eval(Env& env){
+Object Object::eval(Env& env) const {
+    EvalGuard guard(env);
     Object result;
-    switch(this->m_type){
-    case Type::Quote:{
-            List data;
-            unwrap(data);
-            result = data[0];
-        }//
-        break;
-    case Type::Atom:{
-            std::string data;
-            unwrap(data);
-            result = env.get(data);
-        }//
-        break;
-    case Type::List:{
-            List argv;
-            Object fun;
-            List data;
-            unwrap(data);
-            if(data.size() == 0){
-                throw Error(env, ErrorKind::SyntaxError);
-            }
-            argv = std::vector<Object>(data.begin()+1, data.end());
-            fun = data[0].eval(env);
-            if(!fun.is_builtin()){
-                for(size_t i=0; i < argv.size(); i++){
-                    argv[i] = argv[i].eval(env);
+    try{
+        switch(this->m_type){
+        case Type::Quote:{
+                result = std::get<Slice>(this->m_value)[0];
+            }//
+            break;
+        case Type::Atom:{
+                const Symbol& symbol = std::get<Symbol>(this->m_value);
+                result = env.lookup(symbol.name, *symbol.cache);
+            }//
+            break;
+        case Type::List:{
+                const Slice& data = std::get<Slice>(this->m_value);
+                if(data.size() == 0){
+                    throw Error(env, ErrorKind::SyntaxError);
                 }
+                const Object& head = data[0];
+                if(head.m_type == Type::Atom){
+                    // Call through the head's inline cache; builtins take their
+                    // arguments unevaluated, so the slot can be used in place.
+                    const Symbol& symbol = std::get<Symbol>(head.m_value);
+                    InlineCache& site = *symbol.cache;
+                    const Object& fun = env.lookup(symbol.name, site);
+                    if(fun.is_builtin()){
+                        if(site.path != InlineCache::Generic && this->specialized(fun, site, env, result)){
+                            break;
+                        }
+                        result = fun.apply(List(data.begin()+1, data.end()), env);
+                        break;
+                    }
+                    List argv(data.begin()+1, data.end());
+                    if(fun.m_type == Type::Macro){
+                        Object macro = fun;
+                        auto code = this->expansion(macro, *symbol.cache, env);
+                        result = code->eval(env);
+                        break;
+                    }
+                    Object callee = fun;
+                    for(size_t i=0; i < argv.size(); i++){
+                        argv[i] = argv[i].eval(env);
+                    }
+                    result = callee.apply(std::move(argv), env);
+                    break;
+                }
+                List argv(data.begin()+1, data.end());
+                Object fun = data[0].eval(env);
+                if(fun.m_type == Type::Macro){
+                    result = fun.apply(std::move(argv), env).eval(env);
+                    break;
+                }
+                if(!fun.is_builtin()){
+                    for(size_t i=0; i < argv.size(); i++){
+                        argv[i] = argv[i].eval(env);
+                    }
+                }
+                result = fun.apply(std::move(argv), env);
+            }//
+            break;
+        default:
+            result = *this;
+            break;
+        }
+        if(__builtin_expect(NodeProfile::enabled(), false)){
+            // a read is counted on its atom, a call on the atom at its head
+            bool call = this->m_type == Type::List;
+            const Object& node = call ? std::get<Slice>(this->m_value)[0] : *this;
+            if(node.m_type == Type::Atom){
+                const Symbol& symbol = std::get<Symbol>(node.m_value);
+                NodeProfile::record(symbol.cache, symbol.name, call, result.m_type);
             }
-            result = fun.apply(argv, env);
-        }//
-        break;
-    default:
-        result = *this;
-        break;
+        }
+    }catch(Error& err){
+        // report the innermost form that has a position
+        if(!err.span().known()){
+            err.locate(this->span());
+        }
+        throw;
     }
     return result;
 }
 
 // -*-
-bool Object::is_number() const{
-    return this->m_type==Type::Integer || this->m_type==Type::Float;
-}
-
-// -*-
-bool Object::as_boolean() const{
-    return *this != Object(long(0)) || *this != Object(double(0));
-}
-
-// -*-
-long Object::as_integer() const{
-    if(!this->is_number()){
-        throw Error(Env(), ErrorKind::TypeError);
+// Adaptive path of a call to a builtin; true when it produced the result.
+// A specialised site evaluates its two operands in place and computes on
+// integers directly. When a guard misses it finishes with the builtin's
+// generic operation on the values it already has, so nothing is evaluated
+// twice.
+bool Object::specialized(const Object& fun, InlineCache& site, Env& env, Object& result) const{
+    const Slice& form = std::get<Slice>(this->m_value);
+    const Builtin& builtin = std::get<Builtin>(fun.m_value);
+    if(site.path == InlineCache::Cold){
+        if(++site.heat >= HOT){
+            site.path = InlineCache::Generic;
+            if(form.size() == 3){
+                for(const auto& item: specializations){
+                    if(builtin.frame == specialized_name(item.path)){
+                        site.path = item.path;
+                        break;
+                    }
+                }
+            }
+        }
+        return false;
     }
-    auto self = this->to_integer();
-    long result;
-    self.unwrap(result);
-    return result;
+    if(form.size() != 3){
+        // copies of the head atom share this cache, and a copy may head a
+        // call of another arity
+        deoptimize(site);
+        return false;
+    }
+    if(builtin.frame != specialized_name(site.path)){
+        // the head now names another builtin: learn the site again
+        deoptimize(site);
+        if(site.path != InlineCache::Generic){
+            site.path = InlineCache::Cold;
+            site.heat = 0;
+        }
+        return false;
+    }
+    if(Stats::enabled()){
+        return false;   // keep per-builtin call counts exact
+    }
+    // the operands may run this very site and deoptimize it
+    auto path = site.path;
+    Object x = form[1].eval(env);
+    Object y = form[2].eval(env);
+    if(__builtin_expect(x.m_type == Type::Integer && y.m_type == Type::Integer, true)){
+        long a = std::get<long>(x.m_value);
+        long b = std::get<long>(y.m_value);
+        long z = 0;
+        switch(path){
+        case InlineCache::Add:
+            if(!__builtin_add_overflow(a, b, &z)){
+                result = Object(z);
+                return true;
+            }
+            break;
+        case InlineCache::Sub:
+            if(!__builtin_sub_overflow(a, b, &z)){
+                result = Object(z);
+                return true;
+            }
+            break;
+        case InlineCache::Mul:
+            if(!__builtin_mul_overflow(a, b, &z)){
+                result = Object(z);
+                return true;
+            }
+            break;
+        case InlineCache::Less:
+            result = Object(static_cast<long>(a < b));
+            return true;
+        case InlineCache::Greater:
+            result = Object(static_cast<long>(a > b));
+            return true;
+        case InlineCache::LessEqual:
+            result = Object(static_cast<long>(a <= b));
+            return true;
+        case InlineCache::GreaterEqual:
+            result = Object(static_cast<long>(a >= b));
+            return true;
+        case InlineCache::Equal:
+            result = Object(static_cast<long>(a == b));
+            return true;
+        default:
+            break;
+        }
+    }
+    deoptimize(site);
+    result = generic(path, std::move(x), std::move(y));
+    return true;
 }
 
 // -*-
-double Object::as_float() const{
-    if(!this->is_number()){
-        throw Error(Env(), ErrorKind::TypeError);
+// Expansion of this macro call form. Computed on the first execution and
+// kept on the inline cache of the form's head atom; it is reused for as long
+// as the macro binding and the form's element buffer are the same objects.
+std::shared_ptr<const Object> Object::expansion(
+    const Object& macro, InlineCache& cache, Env& env) const
+{
+    const Slice& form = std::get<Slice>(this->m_value);
+    const Closure& closure = std::get<Closure>(macro.m_value);
+    bool hit = (
+        cache.expansion != nullptr && cache.offset == form.offset &&
+        cache.macro.lock() == closure && cache.form.lock() == form.buffer
+    );
+    if(hit){
+        return cache.expansion;
     }
-    auto self = this->to_float();
-    double result;
-    self.unwrap(result);
+    List args(form.begin()+1, form.end());
+    auto result = std::make_shared<const Object>(macro.apply(std::move(args), env));
+    cache.macro = closure;
+    cache.form = form.buffer;
+    cache.offset = form.offset;
+    cache.expansion = result;
     return result;
 }
 
 // -*-
-std::string Object::as_string() const{
-    if(this->m_type != Type::String){
-        throw Error(Env(), ErrorKind::TypeError);
+Object Object::macroexpand(Env& env) const{
+    if(this->m_type != Type::List || this->list_size() == 0){
+        return *this;
     }
-    std::string result{};
-    auto self = *this;
-    self.unwrap(result);
-    return result;
+    const Object& head = this->list_at(0);
+    if(head.m_type != Type::Atom || !env.contains(head.as_atom())){
+        return *this;
+    }
+    const Object& fun = env.get(head.as_atom());
+    if(fun.m_type != Type::Macro){
+        return *this;
+    }
+    const Slice& form = std::get<Slice>(this->m_value);
+    return fun.apply(List(form.begin()+1, form.end()), env);
 }
 
 // -*-
-std::string Object::as_atom() const {
-    if(this->m_type != Type::Atom){
-        throw Error(Env(), ErrorKind::TypeError);
+Span Object::span() const{
+    if(this->m_type==Type::Atom){
+        return std::get<Symbol>(this->m_value).cache->span;
     }
-    auto self = *this;
-    std::string result{};
-    self.unwrap(result);
-    return result;
+    if(this->m_type==Type::List && this->list_size() > 0){
+        const Object& head = this->list_at(0);
+        if(head.m_type==Type::Atom){
+            return std::get<Symbol>(head.m_value).cache->span;
+        }
+    }
+    return Span();
 }
 
 // -*-
-std::vector<Object> Object::as_list() const{
-    if(this->m_type!=Type::List){
-        throw Error(Env(), ErrorKind::TypeError);
+void Object::locate(const Span& span){
+    if(this->m_type==Type::Atom){
+        std::get<Symbol>(this->m_value).cache->span = span;
     }
-    auto self = *this;
-    std::vector<Object> result = {};
-    self.unwrap(result);
-    return result;
 }
 
 // -*-
-void Object::push(Object obj){
-    if(this->m_type != Type::List){
-        throw Error(Env(), ErrorKind::TypeError);
+// Heap bytes behind a string: nothing while it fits the small buffer inside
+// the string object itself.
+namespace{
+size_t string_size(const std::string& str){
+    const char* data = str.data();
+    const char* self = reinterpret_cast<const char*>(&str);
+    if(data >= self && data < self + sizeof(std::string)){
+        return 0;
     }
-
-    List& self = std::get<List>(this->m_value);
-    self.push_back(obj);
+    return str.capacity() + 1;
 }
 
-// -*-
-Object Object::pop(){
-    if(this->m_type != Type::List){
-        throw Error(Env(), ErrorKind::TypeError);
-    }
-    auto& self = std::get<List>(this->m_value);
-    size_t len = self.size();
-    auto result = self[len-1];
-    self.pop_back();
-    return result;
+// bookkeeping of a shared_ptr control block and of a std::map node
+constexpr size_t CONTROL_BLOCK = 2*sizeof(long);
+constexpr size_t MAP_NODE = 4*sizeof(void*);
 }
 
 // -*-
-Object Object::to_integer() const {
-    if(!this->is_number()){
-        throw Error(Env(), ErrorKind::TypeError);
-    }
-    if(this->m_type == Type::Integer){
-        return *this;
-    }
-    // This object is as Float
-    auto result = Object(static_cast<long>(this->as_float()));
-    return result;
+size_t Object::memory_size() const{
+    std::unordered_set<const void*> seen;
+    return this->memory_size(seen);
 }
 
 // -*-
-Object Object::to_float() const {
-    if(!this->is_number()){
-        throw Error(Env(), ErrorKind::TypeError);
+// Shared blocks (list buffers, closures, tables...) are counted by the first
+// object that reaches them, so the total over several objects is what they
+// hold together.
+size_t Object::memory_size(std::unordered_set<const void*>& seen) const{
+    size_t result = sizeof(Object);
+    switch(this->m_type){
+    case Type::String:{
+        result += string_size(std::get<std::string>(this->m_value));
+    }//
+        break;
+    case Type::Lambda:
+    case Type::Macro:{
+        const auto& closure = std::get<Closure>(this->m_value);
+        if(closure && seen.insert(closure.get()).second){
+            result += CONTROL_BLOCK + sizeof(Lambda);
+            result += Object::memory_size(closure->params, seen);
+            if(closure->body && seen.insert(closure->body.get()).second){
+                result += CONTROL_BLOCK + closure->body->memory_size(seen);
+            }
+            result += closure->env.memory_size(seen) - sizeof(Env);
+            if(closure->memo && seen.insert(closure->memo.get()).second){
+                result += CONTROL_BLOCK + closure->memo->memory_size(seen);
+            }
+        }
+    }//
+        break;
+    case Type::Builtin:{
+        result += string_size(std::get<Builtin>(this->m_value).name);
+    }//
+        break;
+    case Type::List:
+    case Type::Quote:{
+        const auto& buffer = std::get<Slice>(this->m_value).buffer;
+        if(buffer && seen.insert(buffer.get()).second){
+            result += CONTROL_BLOCK + sizeof(List) + Object::memory_size(*buffer, seen);
+        }
+    }//
+        break;
+    case Type::Atom:{
+        const auto& symbol = std::get<Symbol>(this->m_value);
+        result += string_size(symbol.name);
+        if(symbol.cache && seen.insert(symbol.cache.get()).second){
+            result += CONTROL_BLOCK + sizeof(InlineCache);
+        }
+    }//
+        break;
+    case Type::Bignum:{
+        const auto& value = std::get<BignumPtr>(this->m_value);
+        if(value && seen.insert(value.get()).second){
+            result += CONTROL_BLOCK + value->memory_size();
+        }
+    }//
+        break;
+    case Type::F64Vec:{
+        const auto& value = std::get<F64Ptr>(this->m_value);
+        if(value && seen.insert(value.get()).second){
+            result += CONTROL_BLOCK + sizeof(*value) + value->capacity()*sizeof(double);
+        }
+    }//
+        break;
+    case Type::I64Vec:{
+        const auto& value = std::get<I64Ptr>(this->m_value);
+        if(value && seen.insert(value.get()).second){
+            result += CONTROL_BLOCK + sizeof(*value) + value->capacity()*sizeof(long);
+        }
+    }//
+        break;
+    case Type::HashMap:{
+        const auto& value = std::get<HashMapPtr>(this->m_value);
+        if(value && seen.insert(value.get()).second){
+            result += CONTROL_BLOCK + value->memory_size(seen);
+        }
+    }//
+        break;
+    case Type::PVec:{
+        const auto& value = std::get<PVecPtr>(this->m_value);
+        if(value && seen.insert(value.get()).second){
+            result += CONTROL_BLOCK + value->memory_size(seen);
+        }
+    }//
+        break;
+    case Type::PMap:{
+        const auto& value = std::get<PMapPtr>(this->m_value);
+        if(value && seen.insert(value.get()).second){
+            result += CONTROL_BLOCK + value->memory_size(seen);
+        }
+    }//
+        break;
+    case Type::Transient:{
+        const auto& value = std::get<TransientPtr>(this->m_value);
+        if(value && seen.insert(value.get()).second){
+            result += CONTROL_BLOCK + sizeof(Transient) + Object::memory_size(value->items, seen);
+        }
+    }//
+        break;
+    default:
+        // numbers live inside the Object; a Sequence is computed on demand
+        break;
+    }
+    return result;
+}
+
+// -*-
+size_t Object::memory_size(const std::vector<Object>& items, std::unordered_set<const void*>& seen){
+    size_t result = (items.capacity() - items.size())*sizeof(Object);
+    for(const auto& item: items){
+        result += item.memory_size(seen);
+    }
+    return result;
+}
+
+// -*-
+bool Object::is_number() const{
+    return (
+        this->m_type==Type::Integer || this->m_type==Type::Float ||
+        this->m_type==Type::Bignum
+    );
+}
+
+// -*-
+bool Object::as_boolean() const{
+    return *this != Object(long(0)) || *this != Object(double(0));
+}
+
+// -*-
+long Object::as_integer() const{
+    if(this->m_type == Type::Integer){
+        return std::get<long>(this->m_value);
+    }
+    if(this->m_type == Type::Float){
+        return static_cast<long>(std::get<double>(this->m_value));
+    }
+    if(this->m_type == Type::Bignum){
+        throw Error(Env(), ErrorKind::ValueError);
+    }
+    throw Error(Env(), ErrorKind::TypeError);
+}
+
+// -*-
+double Object::as_float() const{
+    if(this->m_type == Type::Float){
+        return std::get<double>(this->m_value);
+    }
+    if(this->m_type == Type::Integer){
+        return static_cast<double>(std::get<long>(this->m_value));
+    }
+    if(this->m_type == Type::Bignum){
+        return std::get<BignumPtr>(this->m_value)->to_double();
+    }
+    throw Error(Env(), ErrorKind::TypeError);
+}
+
+// -*-
+Bignum Object::as_bignum() const{
+    if(this->m_type == Type::Bignum){
+        return *std::get<BignumPtr>(this->m_value);
+    }
+    if(this->m_type == Type::Integer){
+        return Bignum(std::get<long>(this->m_value));
+    }
+    throw Error(Env(), ErrorKind::TypeError);
+}
+
+// -*-
+const std::vector<double>& Object::as_f64vec() const{
+    if(this->m_type != Type::F64Vec){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    return *std::get<F64Ptr>(this->m_value);
+}
+
+// -*-
+const std::vector<long>& Object::as_i64vec() const{
+    if(this->m_type != Type::I64Vec){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    return *std::get<I64Ptr>(this->m_value);
+}
+
+// -*-
+HashMap& Object::as_hashmap() const{
+    if(this->m_type != Type::HashMap){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    return *std::get<HashMapPtr>(this->m_value);
+}
+
+// -*-
+const PersistentVector& Object::as_pvec() const{
+    if(this->m_type != Type::PVec){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    return *std::get<PVecPtr>(this->m_value);
+}
+
+// -*-
+const PersistentMap& Object::as_pmap() const{
+    if(this->m_type != Type::PMap){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    return *std::get<PMapPtr>(this->m_value);
+}
+
+// -*-
+std::string Object::as_string() const{
+    if(this->m_type != Type::String){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    std::string result{};
+    auto self = *this;
+    self.unwrap(result);
+    return result;
+}
+
+// -*-
+std::string Object::as_atom() const {
+    if(this->m_type != Type::Atom){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    return std::get<Symbol>(this->m_value).name;
+}
+
+// -*-
+std::vector<Object> Object::as_list() const{
+    if(this->m_type==Type::Sequence){
+        std::vector<Object> result = {};
+        Object item;
+        auto iter = this->as_sequence().iterate();
+        while(iter->next(item)){
+            result.push_back(std::move(item));
+        }
+        return result;
+    }
+    if(this->m_type!=Type::List){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    auto self = *this;
+    std::vector<Object> result = {};
+    self.unwrap(result);
+    return result;
+}
+
+// -*-
+const Sequence& Object::as_sequence() const{
+    if(this->m_type != Type::Sequence){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    return *std::get<SequencePtr>(this->m_value);
+}
+
+// -*-
+bool Object::is_iterable() const{
+    switch(this->m_type){
+    case Type::List:
+    case Type::Transient:
+    case Type::F64Vec:
+    case Type::I64Vec:
+    case Type::PVec:
+    case Type::HashMap:
+    case Type::PMap:
+    case Type::Sequence:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// -*-
+namespace{
+// Walks an indexable value by position; holding a copy of the value keeps
+// its elements alive and unchanged for the whole walk.
+class ElementCursor: public Iterator{
+public:
+    ElementCursor(const Object& seq, size_t size)
+    : m_seq{seq}, m_index{0}, m_size{size}{}
+
+    bool next(Object& out) override{
+        if(this->m_index >= this->m_size){
+            return false;
+        }
+        switch(this->m_seq.type()){
+        case Type::F64Vec:
+            out = Object(this->m_seq.as_f64vec()[this->m_index]);
+            break;
+        case Type::I64Vec:
+            out = Object(this->m_seq.as_i64vec()[this->m_index]);
+            break;
+        case Type::PVec:
+            out = this->m_seq.as_pvec().at(this->m_index);
+            break;
+        default:
+            out = this->m_seq.list_at(this->m_index);
+            break;
+        }
+        this->m_index++;
+        return true;
+    }
+
+private:
+    Object m_seq;
+    size_t m_index;
+    size_t m_size;
+};
+}
+
+// -*-
+// Maps are walked over a snapshot of their keys.
+std::unique_ptr<Iterator> Object::iterate() const{
+    switch(this->m_type){
+    case Type::List:
+    case Type::Transient:
+        return std::make_unique<ElementCursor>(*this, this->list_size());
+    case Type::F64Vec:
+        return std::make_unique<ElementCursor>(*this, this->as_f64vec().size());
+    case Type::I64Vec:
+        return std::make_unique<ElementCursor>(*this, this->as_i64vec().size());
+    case Type::PVec:
+        return std::make_unique<ElementCursor>(*this, this->as_pvec().size());
+    case Type::HashMap:{
+            Object keys(this->as_hashmap().keys());
+            return std::make_unique<ElementCursor>(keys, keys.list_size());
+        }
+    case Type::PMap:{
+            Object keys(this->as_pmap().keys());
+            return std::make_unique<ElementCursor>(keys, keys.list_size());
+        }
+    case Type::Sequence:
+        return this->as_sequence().iterate();
+    default:
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+}
+
+// -*-
+size_t Object::list_size() const{
+    if(this->m_type==Type::Transient){
+        return std::get<TransientPtr>(this->m_value)->items.size();
+    }
+    if(this->m_type!=Type::List){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    return std::get<Slice>(this->m_value).size();
+}
+
+// -*-
+const Object& Object::list_at(size_t index) const{
+    if(this->m_type==Type::Transient){
+        auto& items = std::get<TransientPtr>(this->m_value)->items;
+        if(index >= items.size()){
+            throw Error(Env(), "index out of range");
+        }
+        return items[index];
+    }
+    if(this->m_type!=Type::List){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    const Slice& slice = std::get<Slice>(this->m_value);
+    if(index >= slice.size()){
+        throw Error(Env(), "index out of range");
+    }
+    return slice[index];
+}
+
+// -*-
+// Elements [start, stop) of a list, sharing the buffer. Bounds are clamped.
+Object Object::slice(size_t start, size_t stop) const{
+    if(this->m_type!=Type::List){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    const Slice& slice = std::get<Slice>(this->m_value);
+    stop = std::min(stop, slice.size());
+    start = std::min(start, stop);
+    Object result;
+    result.m_type = Type::List;
+    result.m_value = Slice{slice.buffer, slice.offset + start, stop - start};
+    return result;
+}
+
+// -*-
+Object::List& Object::mutable_list(){
+    Slice& slice = std::get<Slice>(this->m_value);
+    if(slice.buffer.use_count() > 1 || slice.offset != 0 || slice.length != slice.buffer->size()){
+        Accounting::record(Accounting::ListAlloc);
+        slice.buffer = std::make_shared<List>(slice.begin(), slice.end());
+        slice.offset = 0;
+    }
+    // the caller resets slice.length after resizing the buffer
+    return *slice.buffer;
+}
+
+// -*-
+// Storage an in-place update writes to: a Transient's items, or a List's
+// buffer once it is exclusively owned. Call sync_length() after resizing.
+Object::List& Object::writable(){
+    if(this->m_type == Type::Transient){
+        auto& transient = *std::get<TransientPtr>(this->m_value);
+        if(transient.frozen){
+            throw Error(Env(), "transient list used after freeze");
+        }
+        return transient.items;
+    }
+    if(this->m_type != Type::List){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    return this->mutable_list();
+}
+
+// -*-
+void Object::sync_length(){
+    if(this->m_type == Type::List){
+        Slice& slice = std::get<Slice>(this->m_value);
+        slice.length = slice.buffer->size();
+    }
+}
+
+// -*-
+void Object::push(Object obj){
+    List& self = this->writable();
+    self.push_back(std::move(obj));
+    this->sync_length();
+}
+
+// -*-
+Object Object::pop(){
+    auto& self = this->writable();
+    if(self.empty()){
+        throw Error(Env(), "index out of range");
+    }
+    auto result = std::move(self.back());
+    self.pop_back();
+    this->sync_length();
+    return result;
+}
+
+// -*-
+void Object::insert(size_t index, Object obj){
+    auto& self = this->writable();
+    if(index > self.size()){
+        throw Error(Env(), "index out of range");
+    }
+    self.insert(self.begin() + index, std::move(obj));
+    this->sync_length();
+}
+
+// -*-
+Object Object::remove(size_t index){
+    auto& self = this->writable();
+    if(index >= self.size()){
+        throw Error(Env(), "index out of range");
+    }
+    auto result = std::move(self[index]);
+    self.erase(self.begin() + index);
+    this->sync_length();
+    return result;
+}
+
+// -*-
+void Object::set(size_t index, Object obj){
+    auto& self = this->writable();
+    if(index >= self.size()){
+        throw Error(Env(), "index out of range");
+    }
+    self[index] = std::move(obj);
+}
+
+// -*-
+// Hands the transient's items to a new list without copying them.
+Object Object::freeze(){
+    if(this->m_type != Type::Transient){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    auto& transient = *std::get<TransientPtr>(this->m_value);
+    if(transient.frozen){
+        throw Error(Env(), "transient list used after freeze");
+    }
+    transient.frozen = true;
+    return Object(std::move(transient.items));
+}
+
+// -*-
+Object Object::to_integer() const {
+    if(!this->is_number()){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    if(this->m_type == Type::Integer || this->m_type == Type::Bignum){
+        return *this;
+    }
+    // This object is as Float
+    auto result = Object(static_cast<long>(this->as_float()));
+    return result;
+}
+
+// -*-
+Object Object::to_float() const {
+    if(!this->is_number()){
+        throw Error(Env(), ErrorKind::TypeError);
     }
     if(this->m_type == Type::Float){
         return *this;
     }
-    // This object is an Integer
-    auto result = Object(static_cast<double>(this->as_integer()));
+    // This object is an Integer or a Bignum
+    auto result = Object(this->as_float());
     return result;
 }
 
 // -*-
-bool Object::operator==(Object other) const{
+// Exact: the long is not rounded to a double first, so a float only equals
+// the one integer it represents, and both hash alike through hash_real().
+namespace{
+bool same_number(long x, double y){
+    return (
+        y == std::trunc(y) && y >= -9223372036854775808.0 && y < 9223372036854775808.0 &&
+        static_cast<long>(y) == x
+    );
+}
+}
+
+// -*-
+bool Object::operator==(const Object& other) const{
+    // a lazy sequence equals the list of its elements
+    if(this->m_type==Type::Sequence || other.m_type==Type::Sequence){
+        bool listlike = (
+            (this->m_type==Type::Sequence || this->m_type==Type::List) &&
+            (other.m_type==Type::Sequence || other.m_type==Type::List)
+        );
+        return listlike && Object(this->as_list()) == Object(other.as_list());
+    }
+    if(this->m_type==Type::Bignum || other.m_type==Type::Bignum){
+        if(!this->is_number() || !other.is_number()){
+            return false;
+        }
+        if(this->m_type==Type::Float || other.m_type==Type::Float){
+            return this->as_float() == other.as_float();
+        }
+        return this->as_bignum().compare(other.as_bignum()) == 0;
+    }
     if(this->m_type==Type::Float && other.m_type==Type::Integer){
-        return *this == other.to_float();
+        return same_number(std::get<long>(other.m_value), std::get<double>(this->m_value));
     }
     if(this->m_type==Type::Integer && other.m_type==Type::Float){
-        return this->to_float()==other;
+        return same_number(std::get<long>(this->m_value), std::get<double>(other.m_value));
     }
     if(this->m_type != other.m_type){
         return false;
@@ -322,342 +1389,692 @@ bool Object::operator==(Object other) const{
     bool result = false;
     switch(this->m_type){
     case Type::Float:{
-            double x, y;
-            x = std::get<double>(this->m_value);
-            other.unwrap(y);
-            result = (x == y);
+            result = (
+                std::get<double>(this->m_value) == std::get<double>(other.m_value)
+            );
         }//
         break;
     case Type::Integer:{
-            long x, y;
-            x = std::get<long>(this->m_value);
-            other.unwrap(y);
-            result = (x == y);
+            result = (
+                std::get<long>(this->m_value) == std::get<long>(other.m_value)
+            );
         }//
         break;
     case Type::Builtin:{
-            Builtin fn1;
-            Builtin fn2;
-            fn1 = std::get<Builtin>(this->m_value);
-            other.unwrap(fn2);
+            const Builtin& fn1 = std::get<Builtin>(this->m_value);
+            const Builtin& fn2 = std::get<Builtin>(other.m_value);
             result = (
-                fn1.name==fn2.name && fn1.fun==fn2.fun
+                fn1.fun==fn2.fun && fn1.name==fn2.name
             );
         }
         break;
+    case Type::String:{
+            result = (
+                std::get<std::string>(this->m_value) ==
+                std::get<std::string>(other.m_value)
+            );
+        }//
+        break;
+    case Type::Atom:{
+            result = (
+                std::get<Symbol>(this->m_value).name ==
+                std::get<Symbol>(other.m_value).name
+            );
+        }//
+        break;
+    case Type::Lambda:
+    case Type::Macro:{
+            result = (
+                std::get<Closure>(this->m_value) ==
+                std::get<Closure>(other.m_value)
+            );
+        }//
+        break;
+    case Type::List:{
+            const Slice& x = std::get<Slice>(this->m_value);
+            const Slice& y = std::get<Slice>(other.m_value);
+            result = (
+                x.size() == y.size() &&
+                std::equal(x.begin(), x.end(), y.begin())
+            );
+        }//
+        break;
+    case Type::Quote:{
+            const Slice& x = std::get<Slice>(this->m_value);
+            const Slice& y = std::get<Slice>(other.m_value);
+            result = (x[0]==y[0]);
+        }//
+        break;
+    case Type::F64Vec:{
+            result = this->as_f64vec() == other.as_f64vec();
+        }//
+        break;
+    case Type::I64Vec:{
+            result = this->as_i64vec() == other.as_i64vec();
+        }//
+        break;
+    case Type::HashMap:{
+            result = (
+                std::get<HashMapPtr>(this->m_value) ==
+                std::get<HashMapPtr>(other.m_value)
+            );
+        }//
+        break;
+    case Type::Transient:{
+            result = (
+                std::get<TransientPtr>(this->m_value) ==
+                std::get<TransientPtr>(other.m_value)
+            );
+        }//
+        break;
+    case Type::PVec:{
+            auto& x = this->as_pvec();
+            auto& y = other.as_pvec();
+            result = (&x == &y) || (x.size() == y.size() && x.to_list() == y.to_list());
+        }//
+        break;
+    case Type::PMap:{
+            auto& x = this->as_pmap();
+            auto& y = other.as_pmap();
+            result = (&x == &y) || x.size() == y.size();
+            if(&x != &y && result){
+                for(auto item: x.items()){
+                    auto pair = item.as_list();
+                    auto value = y.find(pair[0]);
+                    if(value == nullptr || !(*value == pair[1])){
+                        result = false;
+                        break;
+                    }
+                }
+            }
+        }//
+        break;
+    default:
+        result = true;
+        break;
+    }
+    return result;
+}
+
+// -*-
+// Structural hash, consistent with operator==: numbers that compare equal
+// hash equally whatever their representation (1, 1.0), aggregates hash their
+// contents, and functions and hash maps hash by identity.
+namespace{
+inline size_t mix(std::uint64_t x){
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+}
+
+inline size_t combine(size_t seed, size_t value){
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+inline size_t hash_real(double x){
+    if(x==std::trunc(x) && x >= -9223372036854775808.0 && x < 9223372036854775808.0){
+        return mix(static_cast<std::uint64_t>(static_cast<long>(x)));
+    }
+    std::uint64_t bits;
+    std::memcpy(&bits, &x, sizeof bits);
+    return mix(bits);
+}
+}
+
+size_t Object::hash() const{
+    size_t result = static_cast<size_t>(this->m_type);
+    switch(this->m_type){
+    case Type::Integer:
+        result = mix(static_cast<std::uint64_t>(std::get<long>(this->m_value)));
+        break;
+    case Type::Float:
+        result = hash_real(std::get<double>(this->m_value));
+        break;
+    case Type::Bignum:
+        // a bignum only ever equals a float through its double value
+        result = hash_real(std::get<BignumPtr>(this->m_value)->to_double());
+        break;
     case Type::String:
+        result = combine(result, std::hash<std::string>{}(std::get<std::string>(this->m_value)));
+        break;
+    case Type::Atom:
+        result = combine(result, std::hash<std::string>{}(std::get<Symbol>(this->m_value).name));
+        break;
+    case Type::Quote:
+    case Type::List:{
+            for(const auto& item: std::get<Slice>(this->m_value)){
+                result = combine(result, item.hash());
+            }
+        }//
+        break;
+    case Type::F64Vec:{
+            for(auto x: this->as_f64vec()){
+                result = combine(result, hash_real(x));
+            }
+        }//
+        break;
+    case Type::I64Vec:{
+            for(auto x: this->as_i64vec()){
+                result = combine(result, mix(static_cast<std::uint64_t>(x)));
+            }
+        }//
+        break;
+    case Type::Lambda:
+    case Type::Macro:
+        result = combine(result, std::hash<const void*>{}(std::get<Closure>(this->m_value).get()));
+        break;
+    case Type::Builtin:
+        result = combine(
+            result, std::hash<const void*>{}(reinterpret_cast<const void*>(std::get<Builtin>(this->m_value).fun))
+        );
+        break;
+    case Type::HashMap:
+        result = combine(result, std::hash<const void*>{}(std::get<HashMapPtr>(this->m_value).get()));
+        break;
+    case Type::Transient:
+        result = combine(result, std::hash<const void*>{}(std::get<TransientPtr>(this->m_value).get()));
+        break;
+    case Type::Sequence:
+        // equal to its list of elements, so hashed the same way
+        result = Object(this->as_list()).hash();
+        break;
+    case Type::PVec:{
+            for(const auto& item: this->as_pvec().to_list()){
+                result = combine(result, item.hash());
+            }
+        }//
+        break;
+    case Type::PMap:{
+            // entries are unordered, so their hashes are summed
+            size_t entries = 0;
+            for(auto item: this->as_pmap().items()){
+                auto pair = item.as_list();
+                entries += combine(pair[0].hash(), pair[1].hash());
+            }
+            result = combine(result, entries);
+        }//
+        break;
+    default:
+        result = mix(result);
+        break;
+    }
+    return result;
+}
+
+// -*-
+// Same value as Object(items).hash(), without building the list.
+size_t Object::hash(const std::vector<Object>& items){
+    size_t result = static_cast<size_t>(Type::List);
+    for(const auto& item: items){
+        result = combine(result, item.hash());
+    }
+    return result;
+}
+
+// -*-
+bool Object::operator!=(const Object& other) const{
+    return !(*this==other);
+}
+
+// -*-
+// Three-way comparison: negative, zero or positive as *this orders before,
+// equal to, or after other. Numbers compare by value whatever their
+// representation, with NaN after every other number; strings and atoms
+// compare lexicographically, and lists and vectors element by element.
+// Anything else, or two values of different kinds, is a TypeError.
+int Object::compare(const Object& other) const{
+    auto sign = [](auto x, auto y) -> int { return (y < x) - (x < y); };
+    auto real = [&sign](double x, double y) -> int {
+        if(std::isnan(x) || std::isnan(y)){
+            return int(std::isnan(x)) - int(std::isnan(y));
+        }
+        return sign(x, y);
+    };
+    if(this->is_number() && other.is_number()){
+        if(this->m_type==Type::Integer && other.m_type==Type::Integer){
+            return sign(std::get<long>(this->m_value), std::get<long>(other.m_value));
+        }
+        if(this->m_type!=Type::Float && other.m_type!=Type::Float){
+            return this->as_bignum().compare(other.as_bignum());
+        }
+        return real(this->as_float(), other.as_float());
+    }
+    if(this->m_type != other.m_type){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+
+    int result = 0;
+    switch(this->m_type){
+    case Type::String:{
+            const auto& x = std::get<std::string>(this->m_value);
+            const auto& y = std::get<std::string>(other.m_value);
+            result = x.compare(y);
+        }//
+        break;
     case Type::Atom:{
-            std::string x, y;
-            x = std::get<std::string>(this->m_value);
-            other.unwrap(y);
-            result = x == y;
+            const auto& x = std::get<Symbol>(this->m_value).name;
+            const auto& y = std::get<Symbol>(other.m_value).name;
+            result = x.compare(y);
+        }//
+        break;
+    case Type::List:{
+            const Slice& x = std::get<Slice>(this->m_value);
+            const Slice& y = std::get<Slice>(other.m_value);
+            if(x.buffer==y.buffer && x.offset==y.offset && x.length==y.length){
+                break;
+            }
+            size_t n = std::min(x.size(), y.size());
+            for(size_t i=0; i < n && result==0; i++){
+                result = x[i].compare(y[i]);
+            }
+            if(result==0){
+                result = sign(x.size(), y.size());
+            }
+        }//
+        break;
+    case Type::F64Vec:{
+            const auto& x = this->as_f64vec();
+            const auto& y = other.as_f64vec();
+            size_t n = std::min(x.size(), y.size());
+            for(size_t i=0; i < n && result==0; i++){
+                result = real(x[i], y[i]);
+            }
+            if(result==0){
+                result = sign(x.size(), y.size());
+            }
         }//
         break;
-    case Type::Lambda:
-    case Type::List:{
-            List x, y;
-            x = std::get<List>(this->m_value);
-            other.unwrap(y);
-            result = (x == y);
+    case Type::I64Vec:{
+            const auto& x = this->as_i64vec();
+            const auto& y = other.as_i64vec();
+            auto pos = std::mismatch(x.begin(), x.begin()+std::min(x.size(), y.size()), y.begin());
+            if(pos.first != x.begin()+std::min(x.size(), y.size())){
+                result = sign(*pos.first, *pos.second);
+            }else{
+                result = sign(x.size(), y.size());
+            }
         }//
         break;
-    case Type::Quote:{
-            List x, y;
-            x = std::get<List>(this->m_value);
-            other.unwrap(y);
-            result = (x[0]==y[0]);
+    case Type::PVec:{
+            const auto& x = this->as_pvec();
+            const auto& y = other.as_pvec();
+            size_t n = std::min(x.size(), y.size());
+            for(size_t i=0; i < n && result==0 && &x != &y; i++){
+                result = x.at(i).compare(y.at(i));
+            }
+            if(result==0){
+                result = sign(x.size(), y.size());
+            }
         }//
         break;
     default:
-        result = true;
-        break;
+        throw Error(Env(), ErrorKind::TypeError);
     }
-    return result;
+    return (result > 0) - (result < 0);
 }
 
 // -*-
-bool Object::operator!=(Object other) const{
-    return !(*this==other);
+bool Object::operator>=(const Object& other) const{
+    return this->compare(other) >= 0;
 }
 
 // -*-
-bool Object::operator>=(Object other) const{
-    return !(*this < other);
+bool Object::operator<=(const Object& other) const{
+    return this->compare(other) <= 0;
 }
 
 // -*-
-bool Object::operator<=(Object other) const{
-    return (*this == other) || (*this < other);
+bool Object::operator>(const Object& other) const{
+    return this->compare(other) > 0;
 }
 
 // -*-
-bool Object::operator>(Object other) const{
-    return !(*this <= other);
+bool Object::operator<(const Object& other) const{
+    return this->compare(other) < 0;
 }
 
-// -*-
-bool Object::operator<(Object other) const{
-    if(!this->is_number()){
-        throw Error(Env(), ErrorKind::TypeError);
+// -*-------------------------------------------------------------------*-
+// -*- Arithmetic                                                      -*-
+// -*-------------------------------------------------------------------*-
+// Binary operators dispatch through a table of kernels indexed by the
+// (lhs, rhs) types. Each kernel reads its operands straight out of the
+// variant, so no temporary Object is built on the way.
+namespace{
+constexpr size_t ntypes = 0
+#define SWZLISP_DEF(type, desc)     + 1
+    SWZLISP_TYPES
+#undef SWZLISP_DEF
+;
+
+typedef Object (*Kernel)(const Object&, const Object&);
+
+// Op::integer() reports overflow by returning false; the caller then
+// redoes the operation with Op::big().
+struct Add{
+    static bool integer(long x, long y, long& z){ return !__builtin_add_overflow(x, y, &z); }
+    static double real(double x, double y){ return x + y; }
+    static Bignum big(const Bignum& x, const Bignum& y){ return x + y; }
+};
+
+struct Sub{
+    static bool integer(long x, long y, long& z){ return !__builtin_sub_overflow(x, y, &z); }
+    static double real(double x, double y){ return x - y; }
+    static Bignum big(const Bignum& x, const Bignum& y){ return x - y; }
+};
+
+struct Mul{
+    static bool integer(long x, long y, long& z){ return !__builtin_mul_overflow(x, y, &z); }
+    static double real(double x, double y){ return x * y; }
+    static Bignum big(const Bignum& x, const Bignum& y){ return x * y; }
+};
+
+struct Div{
+    static bool integer(long x, long y, long& z){
+        if(y == 0){ throw Error(Env(), ErrorKind::ZeroDivisionError); }
+        if(y == -1 && x == std::numeric_limits<long>::min()){ return false; }
+        z = x / y;
+        return true;
     }
-    bool result = false;
-    if(this->m_type==Type::Float){
-        auto self = *this;
-        double x, y;
-        self.unwrap(x);
-        other.to_float().unwrap(y);
-        result = (x < y);
-    }else if(this->m_type==Type::Integer){
-        if(other.m_type==Type::Float){
-            double x, y;
-            this->to_float().unwrap(x);
-            other.unwrap(y);
-            result = (x < y);
-        }else{
-            long x, y;
-            this->to_integer().unwrap(x);
-            other.unwrap(y);
-            result = (x < y);
-        }
+    static double real(double x, double y){
+        if(y == 0.0){ throw Error(Env(), ErrorKind::ZeroDivisionError); }
+        return x / y;
     }
-    return result;
-}
-
-// -*-
-Object Object::operator+(Object other) const {
-    if(other.m_type==Type::Unit && this->is_number()){
-        return *this;
+    static Bignum big(const Bignum& x, const Bignum& y){ return x / y; }
+};
+
+struct Mod{
+    static bool integer(long x, long y, long& z){
+        if(y == 0){ throw Error(Env(), ErrorKind::ZeroDivisionError); }
+        z = (y == -1) ? 0 : x % y;
+        return true;
     }
-    if(this->m_type==Type::Unit && other.is_number()){
-        return other;
+    static double real(double x, double y){
+        if(y == 0.0){ throw Error(Env(), ErrorKind::ZeroDivisionError); }
+        return std::fmod(x, y);
     }
+    static Bignum big(const Bignum& x, const Bignum& y){ return x % y; }
+};
 
-    if(!(this->is_number() && other.is_number())){
-        throw Error(Env(), ErrorKind::SyntaxError);
+// -*-
+template<typename Op>
+Object integer_integer(const Object& x, const Object& y){
+    long z;
+    long a = x.as_integer();
+    long b = y.as_integer();
+    if(Op::integer(a, b, z)){
+        return Object(z);
     }
-    Object result;
+    return Object::create_integer(Op::big(Bignum(a), Bignum(b)));
+}
 
-    if(this->m_type==Type::Float){
-        double x, y;
-        this->to_float().unwrap(x);
-        other.to_float().unwrap(y);
-        result.m_type = Type::Float;
-        result.m_value = (x+y);
-    }else if(this->m_type==Type::Integer){
-        if(other.m_type==Type::Float){
-            double x, y;
-            this->to_float().unwrap(x);
-            other.to_float().unwrap(y);
-            result.m_type = Type::Float;
-            result.m_value = (x + y);
-        }else{
-            long x, y;
-            this->to_integer().unwrap(x);
-            other.to_integer().unwrap(y);
-            result.m_type = Type::Integer;
-            result.m_value = (x+y);
-        }
-    }else{
-        throw Error(Env(), ErrorKind::TypeError);
-    }
-    //! @note: ---- maybe implement the same operator for String & List
+// -*-
+template<typename Op>
+Object bignum_bignum(const Object& x, const Object& y){
+    return Object::create_integer(Op::big(x.as_bignum(), y.as_bignum()));
+}
 
-    return result;
+// -*-
+template<typename Op>
+Object real_real(const Object& x, const Object& y){
+    return Object(Op::real(x.as_float(), y.as_float()));
 }
 
 // -*-
-Object Object::operator-(Object other) const {
-    if(other.m_type==Type::Unit && this->is_number()){
-        return *this;
-    }
-    if(this->m_type==Type::Unit && other.is_number()){
-        return other;
-    }
-    if(!(this->is_number() && other.is_number())){
-        throw Error(Env(), ErrorKind::SyntaxError);
-    }
+// Unit acts as the identity: (+ @ 2) => 2
+Object unit_left(const Object& x, const Object& y){
+    (void)x;
+    return y;
+}
 
-    Object result;
-    if(this->m_type==Type::Float){
-        double x, y;
-        this->to_float().unwrap(x);
-        other.to_float().unwrap(y);
-        result.m_type = Type::Float;
-        result.m_value = (x - y);
-    }else if(this->m_type==Type::Integer){
-        if(other.m_type==Type::Float){
-            double x, y;
-            this->to_float().unwrap(x);
-            other.to_float().unwrap(y);
-            result.m_type = Type::Float;
-            result.m_value = (x - y);
-        }else{
-            long x, y;
-            this->to_integer().unwrap(x);
-            other.to_integer().unwrap(y);
-            result.m_type = Type::Integer;
-            result.m_value = (x - y);
-        }
-    }else{
-        throw Error(Env(), ErrorKind::TypeError);
-    }
+Object unit_right(const Object& x, const Object& y){
+    (void)y;
+    return x;
+}
 
-    return result;
+// -*-
+Object mismatch(const Object& x, const Object& y){
+    (void)x;
+    (void)y;
+    throw Error(Env(), ErrorKind::SyntaxError);
 }
 
 // -*-
-Object Object::operator*(Object other) const {
-    if(this->m_type==Type::Unit && other.is_number()){ return other; }
-    if(other.m_type==Type::Unit && other.is_number()){ return *this; }
-    if(!(this->is_number() && other.is_number())){
-        throw Error(Env(), ErrorKind::SyntaxError);
+// Elementwise kernels for f64vec/i64vec, with numbers broadcast. The
+// result is an i64vec only when both sides are integral.
+struct Operand{
+    const double* f64 = nullptr;
+    const long* i64 = nullptr;
+    double real = 0.0;
+    long integer = 0;
+    bool scalar = false;
+    size_t size = 0;
+    std::vector<double> promoted;
+
+    explicit Operand(const Object& x){
+        if(x.type() == Type::F64Vec){
+            this->f64 = x.as_f64vec().data();
+            this->size = x.as_f64vec().size();
+        }else if(x.type() == Type::I64Vec){
+            this->i64 = x.as_i64vec().data();
+            this->size = x.as_i64vec().size();
+        }else if(x.type() == Type::Integer){
+            this->integer = x.as_integer();
+            this->real = static_cast<double>(this->integer);
+            this->i64 = &this->integer;
+            this->f64 = &this->real;
+            this->scalar = true;
+        }else{
+            this->real = x.as_float();
+            this->f64 = &this->real;
+            this->scalar = true;
+        }
     }
 
-    Object result;
-    if(this->m_type==Type::Float){
-        double x, y;
-        this->to_float().unwrap(x);
-        other.to_float().unwrap(y);
-        result.m_type = Type::Float;
-        result.m_value = (x*y);
-    }else if(this->m_type==Type::Integer){
-        if(other.m_type==Type::Float){
-            double x, y;
-            this->to_float().unwrap(x);
-            other.to_float().unwrap(y);
-            result.m_type = Type::Float;
-            result.m_value = (x * y);
-        }else{
-            long x, y;
-            this->to_integer().unwrap(x);
-            other.to_integer().unwrap(y);
-            result.m_type = Type::Integer;
-            result.m_value = (x * y);
+    bool integral() const { return this->i64 != nullptr; }
+
+    const double* reals(){
+        if(this->f64 == nullptr){
+            this->promoted.assign(this->i64, this->i64 + this->size);
+            this->f64 = this->promoted.data();
         }
-    }else{
-        throw Error(Env(), ErrorKind::TypeError);
+        return this->f64;
     }
-    return result;
+};
+
+// -*-
+template<simd::Op op>
+Object vector_vector(const Object& x, const Object& y){
+    Operand a(x);
+    Operand b(y);
+    if(!a.scalar && !b.scalar && a.size != b.size){
+        throw Error(Env(), "vector length mismatch");
+    }
+    size_t n = a.scalar ? b.size : a.size;
+    if(a.integral() && b.integral()){
+        std::vector<long> z(n);
+        simd::binary(op, a.i64, a.scalar, b.i64, b.scalar, z.data(), n);
+        return Object::create_i64vec(std::move(z));
+    }
+    std::vector<double> z(n);
+    simd::binary(op, a.reals(), a.scalar, b.reals(), b.scalar, z.data(), n);
+    return Object::create_f64vec(std::move(z));
 }
 
 // -*-
-Object Object::operator/(Object other) const {
-    if(this->m_type==Type::Unit && other.is_number()){
-        return other;
+struct Kernels{
+    Kernel table[ntypes][ntypes];
+
+    template<typename Op>
+    static Kernels make(){
+        Kernels self;
+        for(size_t i=0; i < ntypes; i++){
+            for(size_t j=0; j < ntypes; j++){
+                self.table[i][j] = mismatch;
+            }
+        }
+        self.set(Type::Integer, Type::Integer, integer_integer<Op>);
+        self.set(Type::Integer, Type::Float, real_real<Op>);
+        self.set(Type::Float, Type::Integer, real_real<Op>);
+        self.set(Type::Float, Type::Float, real_real<Op>);
+        self.set(Type::Bignum, Type::Bignum, bignum_bignum<Op>);
+        self.set(Type::Bignum, Type::Integer, bignum_bignum<Op>);
+        self.set(Type::Integer, Type::Bignum, bignum_bignum<Op>);
+        self.set(Type::Bignum, Type::Float, real_real<Op>);
+        self.set(Type::Float, Type::Bignum, real_real<Op>);
+        self.set(Type::Unit, Type::Integer, unit_left);
+        self.set(Type::Unit, Type::Float, unit_left);
+        self.set(Type::Unit, Type::Bignum, unit_left);
+        self.set(Type::Integer, Type::Unit, unit_right);
+        self.set(Type::Float, Type::Unit, unit_right);
+        self.set(Type::Bignum, Type::Unit, unit_right);
+        return self;
     }
-    if(other.m_type==Type::Unit && this->is_number()){
+
+    template<simd::Op op>
+    Kernels& with_vectors(){
+        const Type vectors[] = {Type::F64Vec, Type::I64Vec};
+        const Type scalars[] = {Type::Integer, Type::Float, Type::Bignum};
+        for(auto v: vectors){
+            for(auto w: vectors){
+                this->set(v, w, vector_vector<op>);
+            }
+            for(auto x: scalars){
+                this->set(v, x, vector_vector<op>);
+                this->set(x, v, vector_vector<op>);
+            }
+            this->set(Type::Unit, v, unit_left);
+            this->set(v, Type::Unit, unit_right);
+        }
         return *this;
     }
 
-    if(!(this->is_number() && other.is_number())){
-        throw Error(Env(), ErrorKind::SyntaxError);
+    void set(Type x, Type y, Kernel kernel){
+        this->table[static_cast<size_t>(x)][static_cast<size_t>(y)] = kernel;
     }
 
-    auto almost_equal = [](double x, double y) -> bool {
-        double eps = std::numeric_limits<double>::epsilon();
-        double delta = std::fabs(x-y);
-        x = std::fabs(x);
-        y = std::fabs(y);
-        double xymax = (x > y) ? x : y;
-        bool result = (delta <= xymax*eps) ? true: false;
-        return result;
-    };
+    Object operator()(const Object& x, const Object& y) const {
+        size_t i = static_cast<size_t>(x.type());
+        size_t j = static_cast<size_t>(y.type());
+        return this->table[i][j](x, y);
+    }
+};
 
-    Object result;
-    if(this->m_type==Type::Float){
-        double x, y;
-        this->to_float().unwrap(x);
-        other.to_float().unwrap(y);
-        if(almost_equal(y, 0.0)){
-            throw Error(Env(), ErrorKind::ZeroDivisionError);
-        }
-        result.m_type = Type::Float;
-        result.m_value = (x / y);
-    }else if(this->m_type==Type::Integer){
-        if(other.m_type==Type::Float){
-            double x, y;
-            this->to_float().unwrap(x);
-            other.to_float().unwrap(y);
-            if(almost_equal(y, 0.0)){
-                throw Error(Env(), ErrorKind::ZeroDivisionError);
+const Kernels addKernels = Kernels::make<Add>().with_vectors<simd::Op::Add>();
+const Kernels subKernels = Kernels::make<Sub>().with_vectors<simd::Op::Sub>();
+const Kernels mulKernels = Kernels::make<Mul>().with_vectors<simd::Op::Mul>();
+const Kernels divKernels = Kernels::make<Div>().with_vectors<simd::Op::Div>();
+const Kernels modKernels = Kernels::make<Mod>();
+
+// -*-
+// Fold (op n1 n2 ...) in unboxed registers: stay in a long while every
+// operand is an integer and switch to a double at the first float. An
+// overflow or any other operand hands the running value over to the boxed
+// kernels.
+template<typename Op>
+Object fold(const std::vector<Object>& args, const Kernels& kernels){
+    long integer = 0;
+    double real = 0.0;
+    bool is_real = false;
+    bool started = false;
+    size_t i = 0;
+    for(; i < args.size(); i++){
+        const Object& arg = args[i];
+        if(arg.type() == Type::Unit){
+            continue;
+        }
+        if(arg.type() == Type::Integer && !is_real){
+            long z = arg.as_integer();
+            if(started && !Op::integer(integer, z, z)){
+                break;      // overflow: the boxed kernel promotes
             }
-            result.m_type = Type::Float;
-            result.m_value = (x / y);
-        }else{
-            long x, y;
-            this->to_integer().unwrap(x);
-            other.to_integer().unwrap(y);
-            if(y==0){
-                throw Error(Env(), ErrorKind::ZeroDivisionError);
+            integer = z;
+        }else if(arg.type() == Type::Integer || arg.type() == Type::Float){
+            if(!is_real){
+                real = static_cast<double>(integer);
+                is_real = true;
             }
-            result.m_type = Type::Integer;
-            result.m_value = (x / y);
+            real = started ? Op::real(real, arg.as_float()) : arg.as_float();
+        }else{
+            break;
         }
-    }else{
-        throw Error(Env(), ErrorKind::TypeError);
+        started = true;
+    }
+    Object result = (
+        !started ? Object() : (is_real ? Object(real) : Object(integer))
+    );
+    for(; i < args.size(); i++){
+        result = kernels(result, args[i]);
     }
     return result;
 }
+}
 
 // -*-
-Object Object::operator%(Object other) const {
-    if(this->m_type==Type::Unit && other.is_number()){
-        return other;
-    }
-    if(other.m_type==Type::Unit && this->is_number()){
-        return *this;
-    }
+Object Object::operator+(const Object& other) const {
+    return addKernels(*this, other);
+}
 
-    if(!(this->is_number() && other.is_number())){
-        throw Error(Env(), ErrorKind::SyntaxError);
-    }
+// -*-
+Object Object::operator-(const Object& other) const {
+    return subKernels(*this, other);
+}
 
-    auto almost_equal = [](double x, double y) -> bool {
-        double eps = std::numeric_limits<double>::epsilon();
-        double delta = std::fabs(x-y);
-        x = std::fabs(x);
-        y = std::fabs(y);
-        double xymax = (x > y) ? x : y;
-        bool result = (delta <= xymax*eps) ? true: false;
-        return result;
-    };
+// -*-
+Object Object::operator*(const Object& other) const {
+    return mulKernels(*this, other);
+}
 
-    Object result;
-    if(this->m_type==Type::Float){
-        double x, y;
-        this->to_float().unwrap(x);
-        other.to_float().unwrap(y);
-        if(almost_equal(y, 0.0)){
-            throw Error(Env(), ErrorKind::ZeroDivisionError);
-        }
-        result.m_type = Type::Float;
-        result.m_value = std::fmod(x, y);
-    }else if(this->m_type==Type::Integer){
-        if(other.m_type==Type::Float){
-            double x, y;
-            this->to_float().unwrap(x);
-            other.to_float().unwrap(y);
-            if(almost_equal(y, 0.0)){
-                throw Error(Env(), ErrorKind::ZeroDivisionError);
-            }
-            result.m_type = Type::Float;
-            result.m_value = std::fmod(x, y);
-        }else{
-            long x, y;
-            this->to_integer().unwrap(x);
-            other.to_integer().unwrap(y);
-            if(y==0){
-                throw Error(Env(), ErrorKind::ZeroDivisionError);
-            }
-            result.m_type = Type::Integer;
-            result.m_value = (x % y);
-        }
+// -*-
+Object Object::operator/(const Object& other) const {
+    return divKernels(*this, other);
+}
+
+// -*-
+Object Object::operator%(const Object& other) const {
+    return modKernels(*this, other);
+}
+
+// -*-
+// Elementwise comparison of vectors (or a vector and a number) into an
+// i64vec of 0/1 flags.
+Object Object::elementwise(simd::Cmp cmp, const Object& other) const {
+    if(!this->is_vector() && !other.is_vector()){
+        throw Error(Env(), ErrorKind::TypeError);
+    }
+    Operand a(*this);
+    Operand b(other);
+    if(!a.scalar && !b.scalar && a.size != b.size){
+        throw Error(Env(), "vector length mismatch");
+    }
+    size_t n = a.scalar ? b.size : a.size;
+    std::vector<long> z(n);
+    if(a.integral() && b.integral()){
+        simd::compare(cmp, a.i64, a.scalar, b.i64, b.scalar, z.data(), n);
     }else{
-        throw Error(Env(), ErrorKind::RuntimError);
+        simd::compare(cmp, a.reals(), a.scalar, b.reals(), b.scalar, z.data(), n);
     }
-    return result;
+    return Object::create_i64vec(std::move(z));
+}
+
+// -*-
+Object Object::sum(const std::vector<Object>& args){
+    return fold<Add>(args, addKernels);
+}
+
+// -*-
+Object Object::difference(const std::vector<Object>& args){
+    return fold<Sub>(args, subKernels);
+}
+
+// -*-
+Object Object::product(const std::vector<Object>& args){
+    return fold<Mul>(args, mulKernels);
 }
 
+
 // -*-
 std::string Object::type_name(){
     std::string result = swzlispTypes[this->m_type];
@@ -675,7 +2092,7 @@ std::string Object::str(){
         }//
         break;
     case Type::Atom:{
-            unwrap(result);
+            result = std::get<Symbol>(this->m_value).name;
         }//
         break;
     case Type::Integer:{
@@ -686,6 +2103,10 @@ std::string Object::str(){
             result = stream.str();
         }//
         break;
+    case Type::Bignum:{
+            result = std::get<BignumPtr>(this->m_value)->str();
+        }//
+        break;
     case Type::Float:{
             double data;
             this->to_float().unwrap(data);
@@ -698,15 +2119,13 @@ std::string Object::str(){
             unwrap(result);
         }//
         break;
-    case Type::Lambda:{
-            std::string data = "";
-            List items;
-            unwrap(items);
-            for(auto item: items){
-                data += item.repr() + " ";
-            }
-            data = std::string(data.begin(), data.end()-1);
-            result = "(lambda " + data + ")";
+    case Type::Lambda:
+    case Type::Macro:{
+            Closure closure;
+            unwrap(closure);
+            Object params(closure->params);
+            result = (this->m_type==Type::Macro ? "(macro " : "(lambda ");
+            result += params.repr() + " " + closure->body->repr() + ")";
         }//
         break;
     case Type::List:{
@@ -714,12 +2133,43 @@ std::string Object::str(){
             unwrap(items);
             std::string data = "";
             for(auto item: items){
-                data += item.repr() + " ";
+                // nested sequences print as their elements too
+                data += (item.m_type==Type::Sequence ? item.str() : item.repr()) + " ";
+            }
+            if(!data.empty()){
+                data.pop_back();
             }
-            data = std::string(data.begin(), data.end()-1);
             result = "(" + data + ")";
         }//
         break;
+    case Type::F64Vec:
+    case Type::I64Vec:{
+            result = this->vector_repr();
+        }//
+        break;
+    case Type::HashMap:{
+            result = this->hashmap_repr();
+        }//
+        break;
+    case Type::PVec:
+    case Type::PMap:{
+            result = this->persistent_repr();
+        }//
+        break;
+    case Type::Sequence:{
+            // printed by its elements, like the list it stands for; repr()
+            // keeps the constructor form
+            result = Object(this->as_list()).str();
+        }//
+        break;
+    case Type::Transient:{
+            result = "(transient";
+            for(auto item: std::get<TransientPtr>(this->m_value)->items){
+                result += " " + item.repr();
+            }
+            result += ")";
+        }//
+        break;
     case Type::Builtin:{
             Builtin builtin;
             unwrap(builtin);
@@ -749,7 +2199,7 @@ std::string Object::repr() {
         }//
         break;
     case Type::Atom:{
-            unwrap(result);
+            result = std::get<Symbol>(this->m_value).name;
         }//
         break;
     case Type::Integer:{
@@ -760,6 +2210,10 @@ std::string Object::repr() {
             result = stream.str();
         }//
         break;
+    case Type::Bignum:{
+            result = std::get<BignumPtr>(this->m_value)->str();
+        }//
+        break;
     case Type::Float:{
             double x;
             this->to_float().unwrap(x);
@@ -775,18 +2229,16 @@ std::string Object::repr() {
                 if(data[i]=='"'){ result += "\\\""; }
                 else{ result.push_back(data[i]); }
             }
-            result = "\"" + data + "\"";
+            result = "\"" + result + "\"";
         }//
         break;
-    case Type::Lambda:{
-            List items;
-            unwrap(items);
-            std::string data = "";
-            for(auto item: items){
-                data += item.repr() + " ";
-            }
-            data = std::string(data.begin(), data.end()-1);
-            result = "(lambda " + data + ")";
+    case Type::Lambda:
+    case Type::Macro:{
+            Closure closure;
+            unwrap(closure);
+            Object params(closure->params);
+            result = (this->m_type==Type::Macro ? "(macro " : "(lambda ");
+            result += params.repr() + " " + closure->body->repr() + ")";
         }//
         break;
     case Type::List:{
@@ -796,10 +2248,38 @@ std::string Object::repr() {
             for(auto item: items){
                 data += item.repr() + " ";
             }
-            data = std::string(data.begin(), data.end()-1);
+            if(!data.empty()){
+                data.pop_back();
+            }
             result = "(" + data + ")";
         }//
         break;
+    case Type::F64Vec:
+    case Type::I64Vec:{
+            result = this->vector_repr();
+        }//
+        break;
+    case Type::HashMap:{
+            result = this->hashmap_repr();
+        }//
+        break;
+    case Type::PVec:
+    case Type::PMap:{
+            result = this->persistent_repr();
+        }//
+        break;
+    case Type::Sequence:{
+            result = this->as_sequence().repr();
+        }//
+        break;
+    case Type::Transient:{
+            result = "(transient";
+            for(auto item: std::get<TransientPtr>(this->m_value)->items){
+                result += " " + item.repr();
+            }
+            result += ")";
+        }//
+        break;
     case Type::Builtin:{
             Builtin builtin;
             unwrap(builtin);
@@ -819,6 +2299,55 @@ std::string Object::repr() {
     return result;
 }
 
+// -*-
+// (f64vec 1 2 3): evaluating the printed form rebuilds the vector
+std::string Object::vector_repr() const{
+    std::ostringstream stream;
+    if(this->m_type == Type::F64Vec){
+        stream << "(f64vec";
+        for(auto x: this->as_f64vec()){ stream << " " << x; }
+    }else{
+        stream << "(i64vec";
+        for(auto x: this->as_i64vec()){ stream << " " << x; }
+    }
+    stream << ")";
+    return stream.str();
+}
+
+// -*-
+// (hash-map key1 value1 ...). Keys and values are printed unquoted, so the
+// form only rebuilds the table when they all evaluate to themselves, as
+// numbers and strings do; list and atom keys or values would be evaluated.
+std::string Object::hashmap_repr() const{
+    std::string result = "(hash-map";
+    for(auto item: this->as_hashmap().items()){
+        auto pair = item.as_list();
+        result += " " + pair[0].repr() + " " + pair[1].repr();
+    }
+    result += ")";
+    return result;
+}
+
+// -*-
+// (pvec x1 x2 ...) and (pmap key1 value1 ...)
+std::string Object::persistent_repr() const{
+    std::string result;
+    if(this->m_type == Type::PVec){
+        result = "(pvec";
+        for(auto item: this->as_pvec().to_list()){
+            result += " " + item.repr();
+        }
+    }else{
+        result = "(pmap";
+        for(auto item: this->as_pmap().items()){
+            auto pair = item.as_list();
+            result += " " + pair[0].repr() + " " + pair[1].repr();
+        }
+    }
+    result += ")";
+    return result;
+}
+
 // -*-------------------------------------------------------------------*-
 // -*- Error                                                           -*-
 // -*-------------------------------------------------------------------*-
@@ -846,105 +2375,191 @@ static std::string get_default_error_message(ErrorKind err){
 }
 
 // -*-
-Error::Error(){
-    this->m_error = ErrorKind::RuntimError;
-    //this->m_reason = Object().get_pointer();
-    this->m_env = Env();
-    this->m_message = "";
-}
+Error::Error(): m_error{ErrorKind::RuntimError}{}
 
-/*
-ErrorKind m_error;
-std::shared_ptr<T> m_reason;
-Env<T> m_env;
-const char* m_message;
-*/
 // -*-
-Error::Error(const Env& env, ErrorKind err){
-    this->m_error = err;
-    //this->m_reason = value.get_pointer();
-    this->m_env = env;
+Error::Error(const Env& env, ErrorKind err)
+: m_error{err}, m_frame{env.weak_from_this()}{
     auto entry = swzlispExceptions.find(err);
     if(entry == swzlispExceptions.end()){
         this->m_error = ErrorKind::RuntimError;
     }
-    this->m_message = "";
 }
 
 // -*-
-Error::Error(const Env& env, const char *message){
-    this->m_error = ErrorKind::RuntimError;
-    //this->m_reason = value.get_pointer();
-    this->m_env = env;
-    this->m_message = message;
+Error::Error(const Env& env, const char *message)
+: m_error{ErrorKind::RuntimError}, m_message{message}, m_frame{env.weak_from_this()}{}
+
+// -*-
+Error::Error(ErrorKind kind, std::string message)
+: m_error{kind}, m_message{std::move(message)}{}
+
+// -*-
+std::string Error::message() const{
+    if(this->m_message==""){
+        return get_default_error_message(this->m_error);
+    }
+    return this->m_message;
 }
 
 // -*-
-Error::Error(const Error& other){
-    this->m_error = other.m_error;
-    this->m_env = other.m_env;
-    //this->m_reason = other.m_reason;
-    this->m_message = other.m_message;
+std::string Error::describe() const{
+    std::string result = swzlispExceptions[this->m_error] + ": " + this->message();
+    if(this->m_span.known()){
+        result += " at " + this->m_span.str();
+    }
+    return result;
 }
 
+// -*-------------------------------------------------------------------*-
+// -*- Span                                                            -*-
+// -*-------------------------------------------------------------------*-
+namespace{
+// never destroyed: spans are still printed by atexit handlers, such as the
+// one that flushes --trace output
+std::vector<std::string>& filenames(){
+    static auto* names = new std::vector<std::string>{"<input>"};
+    return *names;
+}
+}
 
-std::string Error::describe(){
-    std::string result = swzlispExceptions[this->m_error] + ": ";
-    if(this->m_message==""){
-        result += get_default_error_message(this->m_error);
-    }else{
-        result += this->m_message;
+// -*-
+std::uint16_t Span::intern(const std::string& filename){
+    auto& names = filenames();
+    auto pos = std::find(names.begin(), names.end(), filename);
+    if(pos != names.end()){
+        return static_cast<std::uint16_t>(pos - names.begin());
     }
-    return result;
+    if(names.size() > std::numeric_limits<std::uint16_t>::max()){
+        return 0;
+    }
+    names.push_back(filename);
+    return static_cast<std::uint16_t>(names.size() - 1);
+}
+
+// -*-
+std::string Span::str() const{
+    std::ostringstream stream;
+    stream << filenames()[this->file] << ":" << this->line << ":" << this->column;
+    return stream.str();
 }
 
 // -*-------------------------------------------------------------------*-
 // -*- Env                                                             -*-
 // -*-------------------------------------------------------------------*-
+std::uint64_t Env::s_clock = 0;
+
 Env::Env(){
     this->m_bindings = {};
     this->m_parent = nullptr;
+    this->m_version = ++Env::s_clock;
+    this->m_mask = 0;
+    this->m_calls_mask = 0;
+    this->m_outer = this;
 }
 
-Env::Env(const Env& other){
-    this->m_bindings = {};
-    for(auto entry=other.m_bindings.begin(); entry!=other.m_bindings.end(); entry++){
-        this->m_bindings[entry->first] = entry->second;
-    }
+Env::Env(const Env& other): enable_shared_from_this(){
+    Accounting::record(Accounting::EnvCopy);
+    this->m_bindings = other.m_bindings;
     this->m_parent = other.m_parent;
+    this->m_version = ++Env::s_clock;
+    this->m_mask = other.m_mask;
+    this->m_calls_mask = other.m_calls_mask;
+    this->m_outer = other.m_outer == &other ? this : other.m_outer;
 }
 
-bool Env::contains(const std::string& name) const {
-    bool result = false;
-    auto ptr = this->m_bindings.find(name);
-    if(ptr!=this->m_bindings.end()){
-        result = true;
-    }else{
-        result = this->m_parent->contains(name);
+Env& Env::operator=(const Env& other){
+    if(this != &other){
+        Accounting::record(Accounting::EnvCopy);
+        this->m_bindings = other.m_bindings;
+        this->m_parent = other.m_parent;
+        this->m_version = ++Env::s_clock;
+        this->m_mask = other.m_mask;
+        this->m_calls_mask = other.m_calls_mask;
+        this->m_outer = other.m_outer == &other ? this : other.m_outer;
+    }
+    return *this;
+}
+
+// -*-
+void Env::set_caller(const std::shared_ptr<Env>& caller){
+    this->m_parent = caller;
+    this->m_calls_mask = this->m_mask | caller->m_calls_mask;
+    this->m_outer = caller->m_outer;
+}
+
+// -*-
+size_t Env::memory_size(std::unordered_set<const void*>& seen) const{
+    size_t result = sizeof(Env);
+    for(const auto& [name, value]: this->m_bindings){
+        result += MAP_NODE + sizeof(name) + string_size(name) + value.memory_size(seen);
     }
     return result;
 }
 
-const Object& Env::get(std::string name) const {
-    auto entry = this->m_bindings.find(name);
-    if(entry != this->m_bindings.end()){
-        return entry->second;
-    }else if(this->m_parent != nullptr){
-        entry = this->m_parent->m_bindings.find(name);
-        if(entry != this->m_parent->m_bindings.end()){
+bool Env::contains(const std::string& name) const {
+    for(const Env* frame = this; frame != nullptr; frame = frame->m_parent.get()){
+        if(frame->m_bindings.find(name) != frame->m_bindings.end()){
+            return true;
+        }
+    }
+    return false;
+}
+
+const Object& Env::get(const std::string& name) const {
+    for(const Env* frame = this; frame != nullptr; frame = frame->m_parent.get()){
+        auto entry = frame->m_bindings.find(name);
+        if(entry != frame->m_bindings.end()){
             return entry->second;
-        }else{
-            return this->m_parent->get(name);
         }
     }
-    throw std::runtime_error(
-        "'" + name + "' has no binding in the current environment"
-    );
+    throw Error(*this, ("'" + name + "' has no binding in the current environment").c_str());
 }
 
 // -*-
-void Env::put(std::string name, Object& value){
+Object& Env::binding(const std::string& name){
+    for(Env* frame = this; frame != nullptr; frame = frame->m_parent.get()){
+        auto entry = frame->m_bindings.find(name);
+        if(entry != frame->m_bindings.end()){
+            return entry->second;
+        }
+    }
+    throw Error(*this, ("'" + name + "' has no binding in the current environment").c_str());
+}
+
+// -*-
+// Walk the frames towards the cached one. A frame whose bloom mask cannot
+// contain the name is skipped without touching its map, and so is the
+// whole run of call frames when none of them can; the cached frame
+// answers directly while its version stamp is unchanged.
+const Object& Env::lookup(const std::string& name, InlineCache& cache) const {
+    const Env* start = (this->m_calls_mask & cache.bits) != cache.bits ? this->m_outer : this;
+    for(const Env* frame = start; frame != nullptr; frame = frame->m_parent.get()){
+        if(frame == cache.frame && frame->m_version == cache.version){
+            return *cache.slot;
+        }
+        if((frame->m_mask & cache.bits) != cache.bits){
+            continue;
+        }
+        auto entry = frame->m_bindings.find(name);
+        if(entry != frame->m_bindings.end()){
+            cache.frame = frame;
+            cache.version = frame->m_version;
+            cache.slot = &entry->second;
+            return entry->second;
+        }
+    }
+    throw Error(*this, ("'" + name + "' has no binding in the current environment").c_str());
+}
+
+// -*-
+void Env::put(const std::string& name, const Object& value){
     this->m_bindings[name] = value;
+    this->m_mask |= Env::name_bits(name);
+    if(this->m_outer != this){
+        this->m_calls_mask |= Env::name_bits(name);
+    }
+    this->m_version = ++Env::s_clock;
 }
 
 void Env::merge(const Env& other){
@@ -953,6 +2568,11 @@ void Env::merge(const Env& other){
         this->m_bindings[entry->first] = entry->second;
         entry++;
     }
+    this->m_mask |= other.m_mask;
+    if(this->m_outer != this){
+        this->m_calls_mask |= other.m_mask;
+    }
+    this->m_version = ++Env::s_clock;
 }
 
 // -*-------------------------------------------------------------------*-
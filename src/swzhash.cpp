@@ -0,0 +1,242 @@
+#include "swzlisp.hpp"
+#if defined(__SSE2__)
+#include<emmintrin.h>
+#endif
+
+// -*-------------------------------------------------------------------*-
+// -*- namespace::swzlisp                                              -*-
+// -*-------------------------------------------------------------------*-
+namespace swzlisp{
+// -*-------------------------------------------------------------------*-
+// -*- HashMap                                                         -*-
+// -*-------------------------------------------------------------------*-
+// The table is split into groups of sixteen slots. A control byte is Empty,
+// Deleted, or the low 7 bits (h2) of a full slot's hash; the remaining bits
+// (h1) pick the first group. Probing walks whole groups with a triangular
+// step, which visits every group when the group count is a power of two,
+// and stops at the first group that still has an Empty slot.
+namespace{
+constexpr std::int8_t EMPTY = -128;     // 0b10000000
+constexpr std::int8_t DELETED = -2;     // 0b11111110
+constexpr size_t GROUP = 16;
+constexpr size_t NPOS = static_cast<size_t>(-1);
+
+inline size_t h1(size_t hash){ return hash >> 7; }
+inline std::int8_t h2(size_t hash){ return static_cast<std::int8_t>(hash & 0x7f); }
+
+// -*-
+// Bit i is set when ctrl[i] == byte.
+inline std::uint32_t match(const std::int8_t* ctrl, std::int8_t byte){
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return static_cast<std::uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(byte)))
+    );
+#else
+    std::uint32_t bits = 0;
+    for(size_t i=0; i < GROUP; i++){
+        bits |= std::uint32_t(ctrl[i]==byte) << i;
+    }
+    return bits;
+#endif
+}
+
+// -*-
+// Bit i is set when slot i is free (Empty or Deleted): only those bytes
+// have their sign bit set.
+inline std::uint32_t match_free(const std::int8_t* ctrl){
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(group));
+#else
+    std::uint32_t bits = 0;
+    for(size_t i=0; i < GROUP; i++){
+        bits |= std::uint32_t(ctrl[i] < 0) << i;
+    }
+    return bits;
+#endif
+}
+
+inline unsigned lowest(std::uint32_t bits){
+    return static_cast<unsigned>(__builtin_ctz(bits));
+}
+}
+
+// -*-
+HashMap::HashMap(): m_size{0}, m_tombstones{0}{}
+
+// -*-
+size_t HashMap::locate(const Object& key, size_t hash) const{
+    if(this->m_ctrl.empty()){
+        return NPOS;
+    }
+    const size_t mask = this->m_ctrl.size()/GROUP - 1;
+    size_t group = h1(hash) & mask;
+    for(size_t step=0; step <= mask; step++){
+        const std::int8_t* ctrl = &this->m_ctrl[group*GROUP];
+        auto bits = match(ctrl, h2(hash));
+        while(bits){
+            size_t slot = group*GROUP + lowest(bits);
+            if(this->m_hashes[slot]==hash && this->m_keys[slot]==key){
+                return slot;
+            }
+            bits &= bits - 1;
+        }
+        if(match(ctrl, EMPTY)){
+            return NPOS;
+        }
+        group = (group + step + 1) & mask;
+    }
+    return NPOS;
+}
+
+// -*-
+const Object* HashMap::find(const Object& key) const{
+    size_t slot = this->locate(key, key.hash());
+    return slot==NPOS ? nullptr : &this->m_values[slot];
+}
+
+// -*-
+void HashMap::insert(const Object& key, const Object& value){
+    size_t hash = key.hash();
+    size_t slot = this->locate(key, hash);
+    if(slot != NPOS){
+        this->m_values[slot] = value;
+        return;
+    }
+
+    // keep the load (tombstones included) at or below 7/8
+    size_t capacity = this->m_ctrl.size();
+    if((this->m_size + this->m_tombstones + 1)*8 > capacity*7){
+        size_t target = capacity==0 ? GROUP : capacity;
+        while((this->m_size + 1)*16 > target*7){
+            target *= 2;
+        }
+        this->rehash(target);
+    }
+
+    const size_t mask = this->m_ctrl.size()/GROUP - 1;
+    size_t group = h1(hash) & mask;
+    for(size_t step=0; ; step++){
+        auto bits = match_free(&this->m_ctrl[group*GROUP]);
+        if(bits){
+            slot = group*GROUP + lowest(bits);
+            break;
+        }
+        group = (group + step + 1) & mask;
+    }
+    if(this->m_ctrl[slot]==DELETED){
+        this->m_tombstones--;
+    }
+    this->m_ctrl[slot] = h2(hash);
+    this->m_hashes[slot] = hash;
+    this->m_keys[slot] = key;
+    this->m_values[slot] = value;
+    this->m_size++;
+}
+
+// -*-
+bool HashMap::erase(const Object& key){
+    size_t slot = this->locate(key, key.hash());
+    if(slot==NPOS){
+        return false;
+    }
+    // A probe only runs past a group that has no Empty slot, so a slot in a
+    // group that still has one can be emptied outright.
+    const std::int8_t* ctrl = &this->m_ctrl[slot - slot % GROUP];
+    if(match(ctrl, EMPTY)){
+        this->m_ctrl[slot] = EMPTY;
+    }else{
+        this->m_ctrl[slot] = DELETED;
+        this->m_tombstones++;
+    }
+    this->m_keys[slot] = Object();
+    this->m_values[slot] = Object();
+    this->m_size--;
+    return true;
+}
+
+// -*-
+void HashMap::rehash(size_t capacity){
+    std::vector<std::int8_t> ctrl(capacity, EMPTY);
+    std::vector<size_t> hashes(capacity);
+    std::vector<Object> keys(capacity);
+    std::vector<Object> values(capacity);
+
+    const size_t mask = capacity/GROUP - 1;
+    for(size_t i=0; i < this->m_ctrl.size(); i++){
+        if(this->m_ctrl[i] < 0){
+            continue;
+        }
+        size_t hash = this->m_hashes[i];
+        size_t group = h1(hash) & mask;
+        for(size_t step=0; ; step++){
+            auto bits = match(&ctrl[group*GROUP], EMPTY);
+            if(bits){
+                size_t slot = group*GROUP + lowest(bits);
+                ctrl[slot] = h2(hash);
+                hashes[slot] = hash;
+                keys[slot] = std::move(this->m_keys[i]);
+                values[slot] = std::move(this->m_values[i]);
+                break;
+            }
+            group = (group + step + 1) & mask;
+        }
+    }
+
+    this->m_ctrl = std::move(ctrl);
+    this->m_hashes = std::move(hashes);
+    this->m_keys = std::move(keys);
+    this->m_values = std::move(values);
+    this->m_tombstones = 0;
+}
+
+// -*-
+std::vector<Object> HashMap::keys() const{
+    std::vector<Object> result;
+    result.reserve(this->m_size);
+    for(size_t i=0; i < this->m_ctrl.size(); i++){
+        if(this->m_ctrl[i] >= 0){
+            result.push_back(this->m_keys[i]);
+        }
+    }
+    return result;
+}
+
+// -*-
+std::vector<Object> HashMap::values() const{
+    std::vector<Object> result;
+    result.reserve(this->m_size);
+    for(size_t i=0; i < this->m_ctrl.size(); i++){
+        if(this->m_ctrl[i] >= 0){
+            result.push_back(this->m_values[i]);
+        }
+    }
+    return result;
+}
+
+// -*-
+std::vector<Object> HashMap::items() const{
+    std::vector<Object> result;
+    result.reserve(this->m_size);
+    for(size_t i=0; i < this->m_ctrl.size(); i++){
+        if(this->m_ctrl[i] >= 0){
+            result.push_back(Object(std::vector<Object>{this->m_keys[i], this->m_values[i]}));
+        }
+    }
+    return result;
+}
+
+// -*-
+size_t HashMap::memory_size(std::unordered_set<const void*>& seen) const{
+    size_t result = sizeof(HashMap);
+    result += this->m_ctrl.capacity()*sizeof(std::int8_t);
+    result += this->m_hashes.capacity()*sizeof(size_t);
+    result += Object::memory_size(this->m_keys, seen);
+    result += Object::memory_size(this->m_values, seen);
+    return result;
+}
+
+// -*-------------------------------------------------------------------*-
+}//-*- end::namespace::swzlisp                                         -*-
+// -*-------------------------------------------------------------------*-
@@ -1,5 +1,6 @@
 #include "swzlisp.hpp"
-#include<csignal>
+#include<iomanip>
+#include<algorithm>
 
 #define SWZLISP_BUILTINS                    \
     SWZLISP_DEF("eval", _eval)              \
@@ -10,10 +11,36 @@
     SWZLISP_DEF("for", _for)                \
     SWZLISP_DEF("while", _while)            \
     SWZLISP_DEF("scope", _scope)            \
+    SWZLISP_DEF("try", _try)                \
+    SWZLISP_DEF("error", _error)            \
     SWZLISP_DEF("quote", _quote)            \
     SWZLISP_DEF("defun", _defun)            \
+    SWZLISP_DEF("recursion-limit", _recursion_limit) \
+    SWZLISP_DEF("profile-start", _profile_start) \
+    SWZLISP_DEF("profile-stop", _profile_stop) \
+    SWZLISP_DEF("trace-start", _trace_start) \
+    SWZLISP_DEF("trace-stop", _trace_stop)  \
+    SWZLISP_DEF("runtime-stats", _runtime_stats) \
+    SWZLISP_DEF("runtime-stats-enable", _runtime_stats_enable) \
+    SWZLISP_DEF("runtime-stats-reset", _runtime_stats_reset) \
+    SWZLISP_DEF("alloc-stats", _alloc_stats) \
+    SWZLISP_DEF("alloc-stats-enable", _alloc_stats_enable) \
+    SWZLISP_DEF("alloc-stats-reset", _alloc_stats_reset) \
+    SWZLISP_DEF("node-profile", _node_profile) \
+    SWZLISP_DEF("node-profile-enable", _node_profile_enable) \
+    SWZLISP_DEF("node-profile-reset", _node_profile_reset) \
+    SWZLISP_DEF("memory-size", _memory_size) \
+    SWZLISP_DEF("defun-memo", _defun_memo)  \
+    SWZLISP_DEF("memoize", _memoize)        \
+    SWZLISP_DEF("memo-stats", _memo_stats)  \
+    SWZLISP_DEF("memo-clear!", _memo_clear) \
     SWZLISP_DEF("define", _define)          \
     SWZLISP_DEF("lambda", _lambda)          \
+    SWZLISP_DEF("defmacro", _defmacro)      \
+    SWZLISP_DEF("macroexpand", _macroexpand)\
+    SWZLISP_DEF("quasiquote", _quasiquote)  \
+    SWZLISP_DEF("unquote", _unquote)        \
+    SWZLISP_DEF("unquote-splicing", _unquote)\
     SWZLISP_DEF("=", _equalp)               \
     SWZLISP_DEF("!=", _not_equalp)          \
     SWZLISP_DEF(">", _greaterp)             \
@@ -32,8 +59,16 @@
     SWZLISP_DEF("length", _length)          \
     SWZLISP_DEF("push", _push)              \
     SWZLISP_DEF("pop", _pop)                \
+    SWZLISP_DEF("push!", _push_bang)        \
+    SWZLISP_DEF("pop!", _pop_bang)          \
+    SWZLISP_DEF("insert!", _insert_bang)    \
+    SWZLISP_DEF("remove!", _remove_bang)    \
+    SWZLISP_DEF("set-index!", _set_index_bang) \
+    SWZLISP_DEF("transient", _transient)    \
+    SWZLISP_DEF("freeze", _freeze)          \
     SWZLISP_DEF("head", _head)              \
     SWZLISP_DEF("tail", _tail)              \
+    SWZLISP_DEF("slice", _slice)            \
     SWZLISP_DEF("first", _head)             \
     SWZLISP_DEF("rest", _tail)              \
     SWZLISP_DEF("last", _pop)               \
@@ -41,6 +76,8 @@
     SWZLISP_DEF("map", _map)                \
     SWZLISP_DEF("filter", _filter)          \
     SWZLISP_DEF("reduce", _reduce)          \
+    SWZLISP_DEF("sort", _sort)              \
+    SWZLISP_DEF("sort-by", _sort_by)        \
     SWZLISP_DEF("exit", _exit)              \
     SWZLISP_DEF("quit", _exit)              \
     SWZLISP_DEF("print", _print)            \
@@ -49,11 +86,43 @@
     SWZLISP_DEF("linspace", _linspace)      \
     SWZLISP_DEF("import", _import)          \
     SWZLISP_DEF("read-file", _read_file)    \
+    SWZLISP_DEF("write-file", _write_file)  \
+    SWZLISP_DEF("read-lines", _read_lines)  \
     SWZLISP_DEF("repr", _repr)              \
     SWZLISP_DEF("replace", _replace)        \
     SWZLISP_DEF("display", _display)        \
     SWZLISP_DEF("integer", _toInteger)      \
     SWZLISP_DEF("float", _toFloat)          \
+    SWZLISP_DEF("f64vec", _f64vec)          \
+    SWZLISP_DEF("i64vec", _i64vec)          \
+    SWZLISP_DEF("vec->list", _vec_to_list)  \
+    SWZLISP_DEF("vec=", _vec_equalp)        \
+    SWZLISP_DEF("vec!=", _vec_not_equalp)   \
+    SWZLISP_DEF("vec<", _vec_lessp)         \
+    SWZLISP_DEF("vec>", _vec_greaterp)      \
+    SWZLISP_DEF("vec<=", _vec_less_equalp)  \
+    SWZLISP_DEF("vec>=", _vec_greater_equalp) \
+    SWZLISP_DEF("sum", _sum)                \
+    SWZLISP_DEF("dot", _dot)                \
+    SWZLISP_DEF("min", _min)                \
+    SWZLISP_DEF("max", _max)                \
+    SWZLISP_DEF("hash-map", _hash_map)      \
+    SWZLISP_DEF("hash-get", _hash_get)      \
+    SWZLISP_DEF("hash-set!", _hash_set)     \
+    SWZLISP_DEF("hash-remove!", _hash_remove) \
+    SWZLISP_DEF("hash-contains?", _hash_contains) \
+    SWZLISP_DEF("hash-keys", _hash_keys)    \
+    SWZLISP_DEF("hash-values", _hash_values) \
+    SWZLISP_DEF("hash-items", _hash_items)  \
+    SWZLISP_DEF("pvec", _pvec)              \
+    SWZLISP_DEF("pmap", _pmap)              \
+    SWZLISP_DEF("list->pvec", _list_to_pvec) \
+    SWZLISP_DEF("pvec->list", _pvec_to_list) \
+    SWZLISP_DEF("butlast", _butlast)        \
+    SWZLISP_DEF("assoc", _assoc)            \
+    SWZLISP_DEF("dissoc", _dissoc)          \
+    SWZLISP_DEF("get", _get)                \
+    SWZLISP_DEF("contains?", _containsp)    \
     SWZLISP_DEF("float", _newline)
 
 // -*--------------------------------------------------------------------*-
@@ -97,7 +166,7 @@ static Object fun_ifthenelse(std::vector<Object> args, Env& env){
         throw Error(env, "Invalid 'if' expression");
     }
     Object result;
-    Object test = args[0];
+    Object test = args[0].eval(env);
     Object yes = args[1];
     Object no = args[2];
     if(test.as_boolean()){
@@ -135,11 +204,421 @@ static Object fun_defun(std::vector<Object> args, Env& env){
     auto name = args[0].str();
     auto params = args[1].as_list();
     auto body = args[2];
-    auto fun = Object(params, body, env);
+    auto fun = Object(params, body, env).named(name);
     env.put(name, fun);
     return fun;
 }
 
+// -*-
+// (recursion-limit)   => current limit on nested lambda calls
+// (recursion-limit n) => sets it to n and returns the previous one
+static Object fun_recursion_limit(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() > 1){
+        throw Error(env, "Invalid 'recursion-limit' expression.");
+    }
+    auto previous = static_cast<long>(Runtime::recursion_limit);
+    if(args.size() == 1){
+        long limit = args[0].as_integer();
+        if(limit < 1){
+            throw Error(env, "recursion-limit: the limit must be positive");
+        }
+        Runtime::recursion_limit = static_cast<size_t>(limit);
+    }
+    return Object(previous);
+}
+
+// -*-
+// Event names for the tracer, only built while it is on: "what target"
+// for I/O, and the head of a top-level form.
+static FrameName traced(const char* what, const std::string& target){
+    return Tracer::enabled() ? intern_name(std::string(what) + " " + target) : nullptr;
+}
+
+static FrameName traced(const Object& form){
+    if(!Tracer::enabled()){
+        return nullptr;
+    }
+    if(form.type()==Type::List && form.list_size() > 0 && form.list_at(0).type()==Type::Atom){
+        return intern_name(form.list_at(0).as_atom());
+    }
+    return intern_name(swzlispTypes[form.type()]);
+}
+
+// -*-
+// (profile-start [hertz]) starts sampling the call stack, 1000 Hz by default;
+// faster rates are capped at Profiler::MAX_HERTZ
+static Object fun_profile_start(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() > 1){
+        throw Error(env, "Invalid 'profile-start' expression.");
+    }
+    long hertz = args.empty() ? 1000 : args[0].as_integer();
+    if(hertz < 1){
+        throw Error(env, "profile-start: frequency must be positive");
+    }
+    Profiler::start(static_cast<unsigned>(std::min(hertz, static_cast<long>(Profiler::MAX_HERTZ))));
+    return Object();
+}
+
+// -*-
+// (profile-stop [filename]) => number of samples
+// Stops sampling and writes the collapsed stacks to filename, if given.
+static Object fun_profile_stop(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() > 1){
+        throw Error(env, "Invalid 'profile-stop' expression.");
+    }
+    Profiler::stop();
+    if(args.size()==1){
+        std::string filename = args[0].as_string();
+        std::ofstream out(filename);
+        if(!out.is_open()){
+            throw Error(env, ("could not open file '" + filename + "'").c_str());
+        }
+        Profiler::write_folded(out);
+    }
+    return Object(static_cast<long>(Profiler::samples()));
+}
+
+// -*-
+// (trace-start [threshold-us]) starts recording trace events; function
+// calls shorter than the threshold, 100 us by default, are left out
+static Object fun_trace_start(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() > 1){
+        throw Error(env, "Invalid 'trace-start' expression.");
+    }
+    double threshold = args.empty() ? 100.0 : args[0].to_float().as_float();
+    Tracer::start(threshold);
+    return Object();
+}
+
+// -*-
+// (trace-stop [filename]) => number of events kept
+// Stops tracing and writes the events as Chrome trace JSON to filename.
+static Object fun_trace_stop(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() > 1){
+        throw Error(env, "Invalid 'trace-stop' expression.");
+    }
+    Tracer::stop();
+    if(args.size()==1){
+        std::string filename = args[0].as_string();
+        std::ofstream out(filename);
+        if(!out.is_open()){
+            throw Error(env, ("could not open file '" + filename + "'").c_str());
+        }
+        Tracer::write_json(out);
+    }
+    return Object(static_cast<long>(Tracer::events()));
+}
+
+// -*-
+// (runtime-stats) => ((name calls inclusive-seconds exclusive-seconds) ...)
+// sorted by exclusive time, largest first
+static Object fun_runtime_stats(std::vector<Object> args, Env& env){
+    if(!args.empty()){
+        throw Error(env, "Invalid 'runtime-stats' expression.");
+    }
+    std::vector<Object> result;
+    for(const auto& entry: Stats::entries()){
+        result.push_back(Object(std::vector<Object>{
+            Object::create_string(entry.name),
+            Object(static_cast<long>(entry.calls)),
+            Object(entry.inclusive),
+            Object(entry.exclusive)
+        }));
+    }
+    return Object(result);
+}
+
+// -*-
+// (runtime-stats-enable [flag]) turns collection on, or off for a false flag
+static Object fun_runtime_stats_enable(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() > 1){
+        throw Error(env, "Invalid 'runtime-stats-enable' expression.");
+    }
+    Stats::enable(args.empty() || args[0].as_boolean());
+    return Object(static_cast<long>(Stats::enabled()));
+}
+
+// -*-
+static Object fun_runtime_stats_reset(std::vector<Object> args, Env& env){
+    if(!args.empty()){
+        throw Error(env, "Invalid 'runtime-stats-reset' expression.");
+    }
+    Stats::reset();
+    return Object();
+}
+
+// -*-
+// (alloc-stats) => ((name object-copies list-allocs string-allocs env-copies) ...)
+// sorted by total count, largest first
+static Object fun_alloc_stats(std::vector<Object> args, Env& env){
+    if(!args.empty()){
+        throw Error(env, "Invalid 'alloc-stats' expression.");
+    }
+    std::vector<Object> result;
+    for(const auto& entry: Accounting::entries()){
+        std::vector<Object> row{Object::create_string(entry.name)};
+        for(auto count: entry.counts){
+            row.push_back(Object(static_cast<long>(count)));
+        }
+        result.push_back(Object(row));
+    }
+    return Object(result);
+}
+
+// -*-
+// (alloc-stats-enable [flag]) turns counting on, or off for a false flag
+static Object fun_alloc_stats_enable(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() > 1){
+        throw Error(env, "Invalid 'alloc-stats-enable' expression.");
+    }
+    Accounting::enable(args.empty() || args[0].as_boolean());
+    return Object(static_cast<long>(Accounting::enabled()));
+}
+
+// -*-
+static Object fun_alloc_stats_reset(std::vector<Object> args, Env& env){
+    if(!args.empty()){
+        throw Error(env, "Invalid 'alloc-stats-reset' expression.");
+    }
+    Accounting::reset();
+    return Object();
+}
+
+// -*-
+// (node-profile) => ((location node count (type ...) path) ...)
+// by count, largest first; path is empty for variable reads
+static Object fun_node_profile(std::vector<Object> args, Env& env){
+    if(!args.empty()){
+        throw Error(env, "Invalid 'node-profile' expression.");
+    }
+    std::vector<Object> result;
+    for(const auto& entry: NodeProfile::entries()){
+        std::vector<Object> types;
+        for(const auto& type: entry.types){
+            types.push_back(Object::create_string(type));
+        }
+        result.push_back(Object(std::vector<Object>{
+            Object::create_string(entry.location),
+            Object::create_string(entry.node),
+            Object(static_cast<long>(entry.count)),
+            Object(types),
+            Object::create_string(entry.path)
+        }));
+    }
+    return Object(result);
+}
+
+// -*-
+// (node-profile-enable [flag]) turns counting on, or off for a false flag
+static Object fun_node_profile_enable(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() > 1){
+        throw Error(env, "Invalid 'node-profile-enable' expression.");
+    }
+    NodeProfile::enable(args.empty() || args[0].as_boolean());
+    return Object(static_cast<long>(NodeProfile::enabled()));
+}
+
+// -*-
+static Object fun_node_profile_reset(std::vector<Object> args, Env& env){
+    if(!args.empty()){
+        throw Error(env, "Invalid 'node-profile-reset' expression.");
+    }
+    NodeProfile::reset();
+    return Object();
+}
+
+// -*-
+// (memory-size obj) => bytes reachable from obj, shared blocks counted once
+static Object fun_memory_size(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1){
+        throw Error(env, "Invalid 'memory-size' expression.");
+    }
+    return Object(static_cast<long>(args[0].memory_size()));
+}
+
+// -*-
+// default number of results kept by defun-memo and memoize
+static const long MEMO_CAPACITY = 4096;
+
+static size_t memo_capacity(const Object& arg, Env& env){
+    long capacity = arg.as_integer();
+    if(capacity < 0){
+        throw Error(env, "memo: capacity must not be negative");
+    }
+    return static_cast<size_t>(capacity);
+}
+
+// -*-
+// (defun-memo name (param...) body [capacity])
+// Like defun, but results are cached by argument list; recursive calls go
+// through the binding and so hit the cache as well.
+static Object fun_defun_memo(std::vector<Object> args, Env& env){
+    if(args.size() != 3 && args.size() != 4){
+        throw Error(env, "Invalid 'defun-memo' expression");
+    }
+
+    size_t capacity = (
+        args.size()==4 ? memo_capacity(args[3].eval(env), env) : MEMO_CAPACITY
+    );
+    auto name = args[0].str();
+    auto fun = Object(args[1].as_list(), args[2], env).named(name).memoize(capacity);
+    env.put(name, fun);
+    return fun;
+}
+
+// -*-
+// (memoize fun [capacity]) => memoized copy of fun
+static Object fun_memoize(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1 && args.size() != 2){
+        throw Error(env, "Invalid 'memoize' expression");
+    }
+    size_t capacity = (
+        args.size()==2 ? memo_capacity(args[1], env) : MEMO_CAPACITY
+    );
+    return args[0].memoize(capacity);
+}
+
+// -*-
+// (memo-stats fun) => (hits misses size capacity)
+static Object fun_memo_stats(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1 || args[0].memo_cache() == nullptr){
+        throw Error(env, "Invalid 'memo-stats' expression: expected a memoized function");
+    }
+    auto cache = args[0].memo_cache();
+    return Object(std::vector<Object>{
+        Object(static_cast<long>(cache->hits())),
+        Object(static_cast<long>(cache->misses())),
+        Object(static_cast<long>(cache->size())),
+        Object(static_cast<long>(cache->capacity()))
+    });
+}
+
+// -*-
+// (memo-clear! fun) drops the cached results and resets the counters
+static Object fun_memo_clear(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1 || args[0].memo_cache() == nullptr){
+        throw Error(env, "Invalid 'memo-clear!' expression: expected a memoized function");
+    }
+    args[0].memo_cache()->clear();
+    return args[0];
+}
+
+// -*-
+// (defmacro name (param...) body)
+// The body runs on the unevaluated arguments and returns the code to run in
+// their place; each call form is expanded once and the result is cached.
+static Object fun_defmacro(std::vector<Object> args, Env& env){
+    if(args.size() != 3 || args[1].type() != Type::List){
+        throw Error(env, "Invalid 'defmacro' expression");
+    }
+
+    auto name = args[0].str();
+    auto macro = Object::create_macro(args[1].as_list(), args[2], env).named(name);
+    env.put(name, macro);
+    return macro;
+}
+
+// -*-
+// (macroexpand form) -> form with its head macro expanded one step
+static Object fun_macroexpand(std::vector<Object> args, Env& env){
+    if(args.size() != 1){
+        throw Error(env, "Invalid 'macroexpand' expression");
+    }
+    return args[0].eval(env).macroexpand(env);
+}
+
+namespace{
+// -*-
+// name when form is (name x), empty otherwise
+std::string quasi_tag(const Object& form){
+    if(form.type() != Type::List || form.list_size() != 2){
+        return "";
+    }
+    const Object& head = form.list_at(0);
+    return head.type()==Type::Atom ? head.as_atom() : "";
+}
+
+// -*-
+Object quasi(const Object& form, Env& env, size_t depth){
+    if(form.type() == Type::Quote){
+        return Object::create_quote(quasi(form.eval(env), env, depth));
+    }
+    if(form.type() != Type::List){
+        return form;
+    }
+    std::string tag = quasi_tag(form);
+    if(tag == "unquote"){
+        if(depth == 0){
+            return form.list_at(1).eval(env);
+        }
+        return Object(std::vector<Object>{form.list_at(0), quasi(form.list_at(1), env, depth-1)});
+    }
+    if(tag == "quasiquote"){
+        return Object(std::vector<Object>{form.list_at(0), quasi(form.list_at(1), env, depth+1)});
+    }
+
+    std::vector<Object> result;
+    result.reserve(form.list_size());
+    for(size_t i=0; i < form.list_size(); i++){
+        const Object& item = form.list_at(i);
+        if(depth == 0 && quasi_tag(item) == "unquote-splicing"){
+            Object spliced = item.list_at(1).eval(env);
+            if(!spliced.is_iterable()){
+                throw Error(env, "unquote-splicing: expected a list");
+            }
+            Object element;
+            auto iter = spliced.iterate();
+            while(iter->next(element)){
+                result.push_back(element);
+            }
+        }else{
+            result.push_back(quasi(item, env, depth));
+        }
+    }
+    return Object(result);
+}
+}
+
+// -*-
+// (quasiquote form) or `form: quote form, except that ,x is replaced by the
+// value of x and ,@x splices the elements of x into the enclosing list.
+static Object fun_quasiquote(std::vector<Object> args, Env& env){
+    if(args.size() != 1){
+        throw Error(env, "Invalid 'quasiquote' expression");
+    }
+    return quasi(args[0], env, 0);
+}
+
+// -*-
+static Object fun_unquote(std::vector<Object> args, Env& env){
+    (void)args;
+    throw Error(env, "unquote outside of quasiquote");
+}
+
 // -*-
 // (while test body...)
 static Object fun_while(std::vector<Object> args, Env& env){
@@ -158,12 +637,18 @@ static Object fun_while(std::vector<Object> args, Env& env){
 }
 
 // -*-
+// (for x iterable body...)
 static Object fun_for(std::vector<Object> args, Env& env){
+    if(args.size() < 3 || args[0].type()!=Type::Atom){
+        throw Error(env, "Invalid 'for' expression.");
+    }
     Object result;
-    auto argv = args[1].eval(env).as_list();
-    for(size_t i=0; i < argv.size(); i++){
-        env.put(args[0].as_atom(), argv[i]);
-        for(size_t j=1; j < args.size()-1; j++){
+    Object item;
+    auto name = args[0].as_atom();
+    auto iter = args[1].eval(env).iterate();
+    while(iter->next(item)){
+        env.put(name, item);
+        for(size_t j=2; j < args.size()-1; j++){
             args[j].eval(env);
         }
         result = args[args.size()-1].eval(env);
@@ -194,6 +679,69 @@ static Object fun_scope(std::vector<Object> args, Env& env){
     return result;
 }
 
+// -*-
+// (try expr (catch name body...))
+// Value of expr; if it raises, name is bound to (kind message), e.g.
+// ("ValueError" "bad input"), and the body runs in its own frame. Nothing
+// is paid on the path where expr succeeds.
+static Object fun_try(std::vector<Object> args, Env& env){
+    bool valid = (
+        args.size()==2 && args[1].type()==Type::List && args[1].list_size() >= 2 &&
+        args[1].list_at(0).type()==Type::Atom && args[1].list_at(0).as_atom()=="catch" &&
+        args[1].list_at(1).type()==Type::Atom
+    );
+    if(!valid){
+        throw Error(env, "Invalid 'try' expression: expected (try expr (catch name body...))");
+    }
+
+    Object result;
+    Error error;
+    try{
+        return args[0].eval(env);
+    }catch(Error& err){
+        error = err;
+    }catch(std::exception& err){
+        // unbound names and the like
+        error = Error(ErrorKind::RuntimError, err.what());
+    }
+
+    const Object& handler = args[1];
+    Env frame;
+    frame.set_caller(env.get_pointer());
+    frame.put(handler.list_at(1).as_atom(), Object(std::vector<Object>{
+        Object::create_string(swzlispExceptions[error.kind()]),
+        Object::create_string(error.message())
+    }));
+    for(size_t i=2; i < handler.list_size(); i++){
+        result = handler.list_at(i).eval(frame);
+    }
+    return result;
+}
+
+// -*-
+// (error message) or (error kind message), kind being the name of an
+// error such as "ValueError"; RuntimeError when omitted.
+static Object fun_error(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1 && args.size() != 2){
+        throw Error(env, "Invalid 'error' expression.");
+    }
+    ErrorKind kind = ErrorKind::RuntimError;
+    if(args.size()==2){
+        std::string name = args[0].str();
+        auto entry = std::find_if(
+            swzlispExceptions.begin(), swzlispExceptions.end(),
+            [&name](const auto& item){ return item.second == name; }
+        );
+        if(entry == swzlispExceptions.end()){
+            throw Error(env, ("error: unknown error kind '" + name + "'").c_str());
+        }
+        kind = entry->first;
+    }
+    throw Error(kind, args.back().str());
+}
+
 // -*-
 static Object fun_quote(std::vector<Object> args, Env& env){
     std::vector<Object> rv;
@@ -327,6 +875,7 @@ static Object fun_read_file(std::vector<Object> args, Env& env){
     }
 
     auto filename = args[0].as_string();
+    TraceScope scope(traced("read-file", filename), "io");
     auto data = Runtime::read_file(filename);
     return Object::create_string(data);
 }
@@ -340,6 +889,7 @@ static Object fun_write_file(std::vector<Object> args, Env& env){
 
     auto filename = args[0].as_string();
     auto data = args[1].as_string();
+    TraceScope scope(traced("write-file", filename), "io");
     std::ofstream fout(filename);
     long rv = ((fout << data)? 1 : 0);
     if(fout.is_open()){
@@ -358,8 +908,9 @@ static Object fun_import(std::vector<Object> args, Env& env){
 
     Env libenv;
     auto filename = args[0].as_string();
+    TraceScope scope(traced("import", filename), "import");
     auto source = Runtime::read_file(filename);
-    auto result = Runtime::execute(source, libenv);
+    auto result = Runtime::execute(source, libenv, filename);
     env.merge(libenv); 
     return result;
 }
@@ -388,11 +939,7 @@ static Object fun_add(std::vector<Object> args, Env& env){
     if(args.size() < 2){
         throw Error(env, "Invalid '+' expression.");
     }
-    Object result = args[0];
-    for(size_t i=1; i < args.size(); i++){
-        result = result + args[i];
-    }
-    return result;
+    return Object::sum(args);
 }
 
 // -*-
@@ -402,11 +949,7 @@ static Object fun_sub(std::vector<Object> args, Env& env){
     if(args.size() < 2){
         throw Error(env, "Invalid '-' expression.");
     }
-    Object result = args[0];
-    for(size_t i=1; i < args.size(); i++){
-        result = result - args[i];
-    }
-    return result;
+    return Object::difference(args);
 }
 
 // -*-
@@ -416,11 +959,7 @@ static Object fun_mul(std::vector<Object> args, Env& env){
     if(args.size() < 2){
         throw Error(env, "Invalid '*' expression.");
     }
-    Object result = args[0];
-    for(size_t i=1; i < args.size(); i++){
-        result = result * args[i];
-    }
-    return result;
+    return Object::product(args);
 }
 
 // -*-
@@ -457,8 +996,8 @@ static Object fun_equalp(std::vector<Object> args, Env& env){
         throw Error(env, "Invalid '=' expression.");
     }
     
-    auto x = args[0];
-    auto y = args[1];
+    const auto& x = args[0];
+    const auto& y = args[1];
     Object result = Object(static_cast<long>(x == y));
     return result;
 }
@@ -471,8 +1010,8 @@ static Object fun_not_equalp(std::vector<Object> args, Env& env){
         throw Error(env, "Invalid '!=' expression.");
     }
     
-    auto x = args[0];
-    auto y = args[1];
+    const auto& x = args[0];
+    const auto& y = args[1];
     Object result = Object(static_cast<long>(x != y));
     return result;
 }
@@ -485,8 +1024,8 @@ static Object fun_greaterp(std::vector<Object> args, Env& env){
         throw Error(env, "Invalid '>' expression.");
     }
     
-    auto x = args[0];
-    auto y = args[1];
+    const auto& x = args[0];
+    const auto& y = args[1];
     Object result = Object(static_cast<long>(x > y));
     return result;
 }
@@ -499,8 +1038,8 @@ static Object fun_lessp(std::vector<Object> args, Env& env){
         throw Error(env, "Invalid '<' expression.");
     }
     
-    auto x = args[0];
-    auto y = args[1];
+    const auto& x = args[0];
+    const auto& y = args[1];
     Object result = Object(static_cast<long>(x < y));
     return result;
 }
@@ -513,8 +1052,8 @@ static Object fun_greater_equalp(std::vector<Object> args, Env& env){
         throw Error(env, "Invalid '>=' expression.");
     }
     
-    auto x = args[0];
-    auto y = args[1];
+    const auto& x = args[0];
+    const auto& y = args[1];
     Object result = Object(static_cast<long>(x >= y));
     return result;
 }
@@ -527,8 +1066,8 @@ static Object fun_less_equalp(std::vector<Object> args, Env& env){
         throw Error(env, "Invalid '<=' expression.");
     }
     
-    auto x = args[0];
-    auto y = args[1];
+    const auto& x = args[0];
+    const auto& y = args[1];
     Object result = Object(static_cast<long>(x <= y));
     return result;
 }
@@ -575,6 +1114,15 @@ static Object fun_toInteger(std::vector<Object> args, Env& env){
     return args[0].to_integer();
 }
 
+// -*-
+// Builtins that address elements by position need a list: a lazy sequence
+// is realized first.
+static void realize(Object& obj){
+    if(obj.is_sequence()){
+        obj = Object(obj.as_list());
+    }
+}
+
 // -*-
 //(index list i)
 static Object fun_index(std::vector<Object> args, Env& env){
@@ -584,13 +1132,32 @@ static Object fun_index(std::vector<Object> args, Env& env){
         throw Error(env, "Invalid 'index' expression.");
     }
 
-    auto data = args[0].as_list();
     auto idx = args[1].as_integer();
-    if(data.empty() || idx >= data.size()){
+    if(args[0].is_vector()){
+        size_t size = (
+            args[0].type()==Type::F64Vec ?
+            args[0].as_f64vec().size() : args[0].as_i64vec().size()
+        );
+        if(idx < 0 || static_cast<size_t>(idx) >= size){
+            throw Error(env, "index out of range");
+        }
+        if(args[0].type()==Type::F64Vec){
+            return Object(args[0].as_f64vec()[idx]);
+        }
+        return Object(args[0].as_i64vec()[idx]);
+    }
+    if(args[0].is_pvec()){
+        if(idx < 0){
+            throw Error(env, "index out of range");
+        }
+        return args[0].as_pvec().at(idx);
+    }
+    realize(args[0]);
+    if(idx < 0 || static_cast<size_t>(idx) >= args[0].list_size()){
         throw Error(env, "index out of range");
     }
     
-    return data[idx];
+    return args[0].list_at(idx);
 }
 
 // -*-
@@ -639,8 +1206,30 @@ static Object fun_length(std::vector<Object> args, Env& env){
         throw Error(env, "Invalid 'length' expression.");
     }
 
-    auto data = args[0].as_list();
-    return Object(static_cast<long>(data.size()));
+    if(args[0].type()==Type::F64Vec){
+        return Object(static_cast<long>(args[0].as_f64vec().size()));
+    }
+    if(args[0].type()==Type::I64Vec){
+        return Object(static_cast<long>(args[0].as_i64vec().size()));
+    }
+    if(args[0].is_hashmap()){
+        return Object(static_cast<long>(args[0].as_hashmap().size()));
+    }
+    if(args[0].is_pvec()){
+        return Object(static_cast<long>(args[0].as_pvec().size()));
+    }
+    if(args[0].is_pmap()){
+        return Object(static_cast<long>(args[0].as_pmap().size()));
+    }
+    if(args[0].is_sequence()){
+        // a range can hold more elements than a long can count
+        size_t size = args[0].as_sequence().size();
+        if(size > static_cast<size_t>(std::numeric_limits<long>::max())){
+            throw Error(env, "length: sequence too long");
+        }
+        return Object(static_cast<long>(size));
+    }
+    return Object(static_cast<long>(args[0].list_size()));
 }
 
 // -*-
@@ -652,6 +1241,14 @@ static Object fun_push(std::vector<Object> args, Env& env){
         throw Error(env, "Invalid 'push' expression.");
     }
 
+    if(args[0].is_pvec()){
+        auto data = args[0].as_pvec();
+        for(size_t i=1; i < args.size(); i++){
+            data = data.push_back(args[i]);
+        }
+        return Object::create_pvec(data);
+    }
+    realize(args[0]);
     for(size_t i=1; i < args.size(); i++){
         args[0].push(args[i]);
     }
@@ -666,24 +1263,155 @@ static Object fun_pop(std::vector<Object> args, Env& env){
         throw Error(env, "Invalid 'pop' expression.");
     }
 
-    return args[0].pop();
+    if(args[0].is_pvec()){
+        auto& data = args[0].as_pvec();
+        if(data.size() == 0){
+            throw Error(env, "index out of range");
+        }
+        return data.at(data.size()-1);
+    }
+    realize(args[0]);
+    if(args[0].list_size() == 0){
+        throw Error(env, "index out of range");
+    }
+    return args[0].list_at(args[0].list_size()-1);
 }
 
 // -*-
-// (head listObj)
-static Object fun_head(std::vector<Object> args, Env& env){
-    evaluate(args, env);
-
-    if(args.size() != 1){
-        throw Error(env, "Invalid 'head' expression.");
+// The value a mutating builtin updates: the binding slot when the target is
+// a variable, so later reads of the name see the change, or else the
+// evaluated target, which must be a transient since those are shared.
+// Evaluate the other arguments first: that may rebind the variable.
+static Object& mutation_target(const Object& target, Object& scratch, Env& env){
+    if(target.type()==Type::Atom){
+        return env.binding(target.as_atom());
+    }
+    scratch = target.eval(env);
+    if(!scratch.is_transient()){
+        throw Error(env, "expect a variable or a transient list");
     }
+    return scratch;
+}
 
-    auto data = args[0].as_list();
-    if(data.empty()){
+// -*-
+// (push! var item1 item2 ...): amortized O(1) per item
+static Object fun_push_bang(std::vector<Object> args, Env& env){
+    if(args.size() < 2){
+        throw Error(env, "Invalid 'push!' expression.");
+    }
+    for(size_t i=1; i < args.size(); i++){
+        args[i] = args[i].eval(env);
+    }
+    Object scratch;
+    Object& target = mutation_target(args[0], scratch, env);
+    for(size_t i=1; i < args.size(); i++){
+        target.push(std::move(args[i]));
+    }
+    return Object();
+}
+
+// -*-
+// (pop! var) => removed last item
+static Object fun_pop_bang(std::vector<Object> args, Env& env){
+    if(args.size() != 1){
+        throw Error(env, "Invalid 'pop!' expression.");
+    }
+    Object scratch;
+    return mutation_target(args[0], scratch, env).pop();
+}
+
+// -*-
+// (insert! var idx val)
+static Object fun_insert_bang(std::vector<Object> args, Env& env){
+    if(args.size() != 3){
+        throw Error(env, "Invalid 'insert!' expression.");
+    }
+    auto idx = args[1].eval(env).as_integer();
+    auto value = args[2].eval(env);
+    if(idx < 0){
+        throw Error(env, "index out of range");
+    }
+    Object scratch;
+    mutation_target(args[0], scratch, env).insert(idx, std::move(value));
+    return Object();
+}
+
+// -*-
+// (remove! var idx) => removed item
+static Object fun_remove_bang(std::vector<Object> args, Env& env){
+    if(args.size() != 2){
+        throw Error(env, "Invalid 'remove!' expression.");
+    }
+    auto idx = args[1].eval(env).as_integer();
+    if(idx < 0){
         throw Error(env, "index out of range");
     }
+    Object scratch;
+    return mutation_target(args[0], scratch, env).remove(idx);
+}
 
-    return data[0];
+// -*-
+// (set-index! var idx val)
+static Object fun_set_index_bang(std::vector<Object> args, Env& env){
+    if(args.size() != 3){
+        throw Error(env, "Invalid 'set-index!' expression.");
+    }
+    auto idx = args[1].eval(env).as_integer();
+    auto value = args[2].eval(env);
+    if(idx < 0){
+        throw Error(env, "index out of range");
+    }
+    Object scratch;
+    mutation_target(args[0], scratch, env).set(idx, std::move(value));
+    return Object();
+}
+
+// -*-
+// (transient) | (transient listObj): a list to build in place, then freeze
+static Object fun_transient(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() > 1){
+        throw Error(env, "Invalid 'transient' expression.");
+    }
+    if(args.empty()){
+        return Object::create_transient({});
+    }
+    return Object::create_transient(args[0].as_list());
+}
+
+// -*-
+// (freeze transientObj) => listObj
+static Object fun_freeze(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1 || !args[0].is_transient()){
+        throw Error(env, "Invalid 'freeze' expression.");
+    }
+    return args[0].freeze();
+}
+
+// -*-
+// (head listObj)
+static Object fun_head(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1){
+        throw Error(env, "Invalid 'head' expression.");
+    }
+
+    if(args[0].is_pvec()){
+        if(args[0].as_pvec().size() == 0){
+            throw Error(env, "index out of range");
+        }
+        return args[0].as_pvec().at(0);
+    }
+    realize(args[0]);
+    if(args[0].list_size() == 0){
+        throw Error(env, "index out of range");
+    }
+
+    return args[0].list_at(0);
 }
 
 // -*-
@@ -694,13 +1422,28 @@ static Object fun_tail(std::vector<Object> args, Env& env){
         throw Error(env, "Invalid 'tail' expression.");
     }
 
-    std::vector<Object> result{};
-    std::vector<Object> data = args[0].as_list();
-    for(size_t i=1; i < data.size(); i++){
-        result.push_back(data[i]);
+    // a view on the same buffer: no elements are copied
+    realize(args[0]);
+    return args[0].slice(1, args[0].list_size());
+}
+
+// -*-
+// (slice listObj start)
+// (slice listObj start stop)   ; negative indices count from the end
+static Object fun_slice(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() < 2 || args.size() > 3){
+        throw Error(env, "Invalid 'slice' expression.");
     }
+    realize(args[0]);
+    long size = static_cast<long>(args[0].list_size());
+    long start = args[1].as_integer();
+    long stop = args.size()==3 ? args[2].as_integer() : size;
+    if(start < 0){ start = std::max(0L, start + size); }
+    if(stop < 0){ stop = std::max(0L, stop + size); }
 
-    return Object(result);
+    return args[0].slice(start, stop);
 }
 
 // -*-
@@ -759,140 +1502,215 @@ static Object fun_repr(std::vector<Object> args, Env& env){
 }
 
 // -*-
-// (map fun listObj)
-static Object fun_map(std::vector<Object> args, Env& env){
-    evaluate(args, env);
+// Fusion of map/filter pipelines. Builtins see their arguments unevaluated,
+// so map, filter and reduce can recognise a nested (map f ...) or
+// (filter p ...) argument and run the whole chain in a single pass over the
+// innermost source, without building the intermediate lists. Functions are
+// still evaluated outermost first, as before; the per-element calls of the
+// stages now interleave instead of running stage by stage.
+static Object fun_map(std::vector<Object> args, Env& env);
+static Object fun_filter(std::vector<Object> args, Env& env);
+
+namespace{
+struct Stage{
+    enum Kind{ Map, Filter } kind;
+    Object fun;
+};
 
+// -*-
+struct Pipeline{
+    std::vector<Stage> stages;      // outermost first
+    std::unique_ptr<Iterator> source;
+
+    // Next element that survives every stage, innermost stage first.
+    bool next(Object& out, Env& env){
+        Object item;
+        while(this->source->next(item)){
+            bool keep = true;
+            for(size_t k=this->stages.size(); k-- > 0 && keep;){
+                auto& stage = this->stages[k];
+                if(stage.kind == Stage::Map){
+                    item = stage.fun.apply({item}, env);
+                }else{
+                    keep = stage.fun.apply({item}, env).as_boolean();
+                }
+            }
+            if(keep){
+                out = std::move(item);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// -*-
+// Stage kind of an unevaluated (map f xs) / (filter p xs) call whose head
+// still names the builtin; false for anything else.
+bool stage_call(const Object& expr, Env& env, Stage::Kind& kind){
+    static const Object mapBuiltin("map", fun_map);
+    static const Object filterBuiltin("filter", fun_filter);
+    if(expr.type() != Type::List || expr.list_size() != 3){
+        return false;
+    }
+    const Object& head = expr.list_at(0);
+    if(head.type() != Type::Atom || !env.contains(head.as_atom())){
+        return false;
+    }
+    const Object& fun = env.get(head.as_atom());
+    if(fun == mapBuiltin){
+        kind = Stage::Map;
+        return true;
+    }
+    if(fun == filterBuiltin){
+        kind = Stage::Filter;
+        return true;
+    }
+    return false;
+}
+
+// -*-
+// Peels the stage calls nested in `expr` (unevaluated) onto the chain and
+// opens the innermost source.
+void feed(Pipeline& chain, const Object& expr, Env& env){
+    const Object* source = &expr;
+    Stage::Kind kind;
+    while(stage_call(*source, env, kind)){
+        chain.stages.push_back({kind, source->list_at(1).eval(env)});
+        source = &source->list_at(2);
+    }
+    chain.source = source->eval(env).iterate();
+}
+}
+
+// -*-
+// (map fun iterable)
+static Object fun_map(std::vector<Object> args, Env& env){
     if(args.size() != 2){
         throw Error(env, "Invalid 'map' expression.");
     }
-    std::vector<Object> result{};
-    std::vector<Object> tmp{};
-    auto fun = args[0];
-    std::vector<Object> data = args[1].as_list();
     //! @note: fun must be a lambda, builtin or user define function
-    //! @todo: need to handle error appropriately
-    for(size_t i=0; data.size(); i++){
-        tmp.push_back(data[i]);
-        result.push_back(fun.apply(tmp, env));
-        tmp.clear();
+    Pipeline chain;
+    chain.stages.push_back({Stage::Map, args[0].eval(env)});
+    feed(chain, args[1], env);
+    std::vector<Object> result{};
+    Object item;
+    while(chain.next(item, env)){
+        result.push_back(std::move(item));
     }
 
     return Object(result);
 }
 
 // -*-
-// (filter predicate listobj)
+// (filter predicate iterable)
 static Object fun_filter(std::vector<Object> args, Env& env){
-    evaluate(args, env);
-
     if(args.size() != 2){
-        auto error = Error(env, "Invalid 'filter' expression.");
+        throw Error(env, "Invalid 'filter' expression.");
     }
 
+    Pipeline chain;
+    chain.stages.push_back({Stage::Filter, args[0].eval(env)});
+    feed(chain, args[1], env);
     std::vector<Object> result{};
-    std::vector<Object> tmp{};
-    std::vector<Object> data = args[1].as_list();
-    auto predicate = args[0];
-    for(size_t i=0; i < data.size(); i++){
-        tmp.push_back(data[i]);
-        // filter
-        if(predicate.apply(tmp, env).as_boolean()){
-            result.push_back(data[i]);
-        }
-        tmp.clear();
+    Object item;
+    while(chain.next(item, env)){
+        result.push_back(std::move(item));
     }
 
     return Object(result);
 }
 
 // -*-
-// (reduce fun acc listobj)
+// (reduce fun acc iterable)
 static Object fun_reduce(std::vector<Object> args, Env& env){
-    evaluate(args, env);
-
     if(args.size() != 3){
         throw Error(env, "Invalid 'reduce' expression.");
     }
 
-    std::vector<Object> data = args[2].as_list();
-    std::vector<Object> tmp{};
-    Object acc = args[1];
-    Object fun = args[0];
-    for(size_t i=0; i < data.size(); i++){
-        tmp.push_back(acc);
-        tmp.push_back(data[i]);
-        acc = fun.apply(tmp, env);
-        tmp.clear();
+    Object fun = args[0].eval(env);
+    Object acc = args[1].eval(env);
+    Pipeline chain;
+    feed(chain, args[2], env);
+
+    Object item;
+    while(chain.next(item, env)){
+        acc = fun.apply({acc, item}, env);
     }
 
     return acc;
 }
 
 // -*-
-static std::vector<long> my_range(long stop){
-    std::vector<long> result{};
-    long val = 0;
-    while(val < stop){
-        result.push_back(val);
-        val++;
-    }
-    return result;
-}
+// (sort iterable [less]) => sorted copy
+// Without a predicate elements are ordered by Object::compare and vectors
+// stay vectors. With one, (less a b) is true when a must come before b; the
+// sort is then stable and the result is a list.
+static Object fun_sort(std::vector<Object> args, Env& env){
+    evaluate(args, env);
 
-// -
-static std::vector<long> my_range(long start, long stop){
-    std::vector<long> result{};
-    long val = start;
-    while(val < stop){
-        result.push_back(val);
-        val++;
+    if(args.size() != 1 && args.size() != 2){
+        throw Error(env, "Invalid 'sort' expression.");
     }
-    return result;
-}
-
-// -
-static std::vector<double> my_linspace(double start, double stop){
-    std::vector<double> result{};
-    double nstep = 10;
-    double dx = (stop - start)/nstep;
-    size_t i = 0;
-    while(i < nstep){
-        double val = start + i*dx;
-        result.push_back(val);
-        i++;
+    const Object& seq = args[0];
+    if(args.size()==1 && seq.type()==Type::F64Vec){
+        std::vector<double> data = seq.as_f64vec();
+        sorting::sort(data);
+        return Object::create_f64vec(std::move(data));
+    }
+    if(args.size()==1 && seq.type()==Type::I64Vec){
+        std::vector<long> data = seq.as_i64vec();
+        sorting::sort(data);
+        return Object::create_i64vec(std::move(data));
+    }
+    if(!seq.is_iterable()){
+        throw Error(env, "Invalid 'sort' expression: expected an iterable.");
     }
 
-    return result;
-}
-
-static std::vector<long> my_range(long start, long stop, long step){
-    std::vector<long> result{};
-    long val = start;
-    while(val < stop){
-        result.push_back(val);
-        val += step;
+    std::vector<Object> items;
+    Object item;
+    auto iter = seq.iterate();
+    while(iter->next(item)){
+        items.push_back(std::move(item));
     }
-    return result;
+    if(args.size()==1){
+        sorting::sort(items);
+    }else{
+        const Object& less = args[1];
+        std::stable_sort(items.begin(), items.end(), [&](const Object& x, const Object& y){
+            return less.apply({x, y}, env).as_boolean();
+        });
+    }
+    return Object(std::move(items));
 }
 
 // -*-
-static std::vector<double> my_linspace(double start, double stop, size_t nstep){
-    std::vector<double> result{};
-    double dx = (stop - start)/nstep;
-    size_t i = 0;
-    while(i < nstep){
-        double val = start + i * dx;
-        result.push_back(val);
-        i++;
+// (sort-by key iterable) => list sorted by (key item), stable
+// key is called once per element.
+static Object fun_sort_by(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 2 || !args[1].is_iterable()){
+        throw Error(env, "Invalid 'sort-by' expression.");
     }
-    return result;
+    const Object& key = args[0];
+    std::vector<Object> items;
+    std::vector<Object> keys;
+    Object item;
+    auto iter = args[1].iterate();
+    while(iter->next(item)){
+        keys.push_back(key.apply({item}, env));
+        items.push_back(std::move(item));
+    }
+    sorting::sort_by(items, keys);
+    return Object(std::move(items));
 }
 
+// -*-
 // (range stop)             ==> (0, 1, ... stop-1)
 // (range start stop)       ==> (start, start+1, ..., stop-1)
 // (range start stop step)  ==> (start, start+step, ..., last)
-// where last < stop
+// where last < stop (or last > stop when step is negative)
 static Object fun_range(std::vector<Object> args, Env& env){
     evaluate(args, env);
 
@@ -908,45 +1726,20 @@ static Object fun_range(std::vector<Object> args, Env& env){
     err << "(range start stop step) ; result: (start, start+step, ... last) ";
     err << " where last <= stop\n";
 
-    std::vector<Object> result{};
-    if(args.size() == 1){
-        auto stop = args[0];
-        if(!stop.is_integer()){
+    for(auto& arg: args){
+        if(!arg.is_integer()){
             throw Error(env, err.str().c_str());
         }
-        auto values = my_range(stop.as_integer());
-        for(auto val: values){
-            result.emplace_back(Object(val));
-        }
-    }else if(args.size() == 2){
-        auto start = args[0];
-        auto stop = args[1];
-        if(!start.is_integer() || !stop.is_integer()){
-            throw Error(env, err.str().c_str());
-        }
-        auto values = my_range(start.as_integer(), stop.as_integer());
-        for(auto val: values){
-            result.emplace_back(Object(val));
-        }
-    }else if(args.size() == 3){
-        auto start = args[0];
-        auto stop = args[1];
-        auto step = args[2];
-        bool test = (
-            start.is_integer() && stop.is_integer() && step.is_integer()
-        );
-        if(!test){
-            throw Error(env, err.str().c_str());
-        }
-        auto values = my_range(
-            start.as_integer(), stop.as_integer(), step.as_integer()
-        );
-        for(auto val: values){
-            result.emplace_back(Object(val));
-        }
+    }
+    long start = args.size() > 1 ? args[0].as_integer() : 0;
+    long stop = args.size() > 1 ? args[1].as_integer() : args[0].as_integer();
+    long step = args.size() > 2 ? args[2].as_integer() : 1;
+    if(step == 0){
+        throw Error(env, err.str().c_str());
     }
 
-    return Object(result);
+    // elements are produced on demand; see Sequence
+    return Object::create_sequence(Sequence::range(start, stop, step));
 }
 
 // -*-
@@ -956,7 +1749,7 @@ static Object fun_linspace(std::vector<Object> args, Env& env){
     evaluate(args, env);
 
     if(args.size() < 2 || args.size() > 3){
-        auto error = Error(env, "Invalid 'linspace' expression.");
+        throw Error(env, "Invalid 'linspace' expression.");
     }
 
     std::ostringstream err;
@@ -965,48 +1758,535 @@ static Object fun_linspace(std::vector<Object> args, Env& env){
     err << "(range start stop)          ; start and stop are numbers\n";
     err << "(range start stop count)    ; count is an integer\n";
 
-    std::vector<Object> result{};
-    if(args.size() == 2){
-        auto start = args[0];
-        auto stop = args[1];
-        if(!start.is_number() || !stop.is_number()){
-            throw Error(env, err.str().c_str());
+    bool test = args[0].is_number() && args[1].is_number();
+    if(args.size() == 3){
+        test = test && args[2].is_integer() && args[2].as_integer() >= 0;
+    }
+    if(!test){
+        throw Error(env, err.str().c_str());
+    }
+    size_t count = args.size() == 3 ? args[2].as_integer() : 10;
+
+    return Object::create_sequence(
+        Sequence::linspace(args[0].as_float(), args[1].as_float(), count)
+    );
+}
+
+// -*-
+// (read-lines filename): the file's lines, read lazily one at a time
+static Object fun_read_lines(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1 || !args[0].is_string()){
+        throw Error(env, "Invalid 'read-lines' expression.");
+    }
+    return Object::create_sequence(Sequence::lines(args[0].as_string()));
+}
+
+// -*-
+// (f64vec x1 x2 ...)
+// (f64vec listObj)   ; also accepts an i64vec
+static Object fun_f64vec(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    std::vector<double> data{};
+    if(args.size()==1 && args[0].type()==Type::F64Vec){
+        return args[0];
+    }else if(args.size()==1 && args[0].type()==Type::I64Vec){
+        auto& values = args[0].as_i64vec();
+        data.assign(values.begin(), values.end());
+    }else{
+        auto items = (
+            args.size()==1 && (args[0].type()==Type::List || args[0].is_sequence()) ?
+            args[0].as_list() : args
+        );
+        data.reserve(items.size());
+        for(auto& item: items){
+            if(!item.is_number()){
+                throw Error(env, "Invalid 'f64vec' expression: expect numbers");
+            }
+            data.push_back(item.as_float());
         }
-        auto values = my_linspace(start.as_float(), stop.as_float());
-        for(auto val: values){
-            result.emplace_back(Object(val));
+    }
+    return Object::create_f64vec(std::move(data));
+}
+
+// -*-
+// (i64vec n1 n2 ...)
+// (i64vec listObj)   ; also accepts an f64vec, truncating
+static Object fun_i64vec(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    std::vector<long> data{};
+    if(args.size()==1 && args[0].type()==Type::I64Vec){
+        return args[0];
+    }else if(args.size()==1 && args[0].type()==Type::F64Vec){
+        for(auto x: args[0].as_f64vec()){
+            data.push_back(static_cast<long>(x));
         }
-    }else if(args.size() == 3){
-        auto start = args[0];
-        auto stop = args[1];
-        auto step = args[2];
-        bool test = (
-            start.is_number() && stop.is_number() && step.is_integer()
+    }else{
+        auto items = (
+            args.size()==1 && (args[0].type()==Type::List || args[0].is_sequence()) ?
+            args[0].as_list() : args
         );
-        if(!test){
-            throw Error(env, err.str().c_str());
+        data.reserve(items.size());
+        for(auto& item: items){
+            if(!item.is_number()){
+                throw Error(env, "Invalid 'i64vec' expression: expect numbers");
+            }
+            data.push_back(item.as_integer());
         }
-        auto values = my_linspace(
-            start.as_float(), stop.as_float(), step.as_integer()
+    }
+    return Object::create_i64vec(std::move(data));
+}
+
+// -*-
+// (vec->list vecObj)
+static Object fun_vec_to_list(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1 || !args[0].is_vector()){
+        throw Error(env, "Invalid 'vec->list' expression.");
+    }
+    std::vector<Object> result{};
+    if(args[0].type()==Type::F64Vec){
+        for(auto x: args[0].as_f64vec()){ result.emplace_back(x); }
+    }else{
+        for(auto x: args[0].as_i64vec()){ result.emplace_back(x); }
+    }
+    return Object(result);
+}
+
+// -*-
+static Object vector_compare(std::vector<Object>& args, Env& env, simd::Cmp cmp){
+    evaluate(args, env);
+
+    if(args.size() != 2){
+        throw Error(env, "Invalid vector comparison: expect two arguments");
+    }
+    return args[0].elementwise(cmp, args[1]);
+}
+
+// -*-
+// (vec< x y) ... => i64vec of 0/1
+static Object fun_vec_equalp(std::vector<Object> args, Env& env){
+    return vector_compare(args, env, simd::Cmp::Eq);
+}
+
+static Object fun_vec_not_equalp(std::vector<Object> args, Env& env){
+    return vector_compare(args, env, simd::Cmp::Ne);
+}
+
+static Object fun_vec_lessp(std::vector<Object> args, Env& env){
+    return vector_compare(args, env, simd::Cmp::Lt);
+}
+
+static Object fun_vec_greaterp(std::vector<Object> args, Env& env){
+    return vector_compare(args, env, simd::Cmp::Gt);
+}
+
+static Object fun_vec_less_equalp(std::vector<Object> args, Env& env){
+    return vector_compare(args, env, simd::Cmp::Le);
+}
+
+static Object fun_vec_greater_equalp(std::vector<Object> args, Env& env){
+    return vector_compare(args, env, simd::Cmp::Ge);
+}
+
+// -*-
+// (sum vecObj) | (sum listObj)
+static Object fun_sum(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1){
+        throw Error(env, "Invalid 'sum' expression.");
+    }
+    if(args[0].type()==Type::F64Vec){
+        auto& data = args[0].as_f64vec();
+        return Object(simd::sum(data.data(), data.size()));
+    }
+    if(args[0].type()==Type::I64Vec){
+        auto& data = args[0].as_i64vec();
+        return Object(simd::sum(data.data(), data.size()));
+    }
+    auto data = args[0].as_list();
+    if(data.empty()){
+        return Object(long(0));
+    }
+    return Object::sum(data);
+}
+
+// -*-
+// (dot x y)
+static Object fun_dot(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 2 || !args[0].is_vector() || !args[1].is_vector()){
+        throw Error(env, "Invalid 'dot' expression: expect two vectors");
+    }
+    auto& x = args[0];
+    auto& y = args[1];
+    if(x.type()==Type::I64Vec && y.type()==Type::I64Vec){
+        auto& a = x.as_i64vec();
+        auto& b = y.as_i64vec();
+        if(a.size() != b.size()){
+            throw Error(env, "vector length mismatch");
+        }
+        return Object(simd::dot(a.data(), b.data(), a.size()));
+    }
+    auto reals = [](const Object& v) -> std::vector<double> {
+        if(v.type()==Type::F64Vec){
+            return v.as_f64vec();
+        }
+        auto& values = v.as_i64vec();
+        return std::vector<double>(values.begin(), values.end());
+    };
+    if(x.type()==Type::F64Vec && y.type()==Type::F64Vec){
+        auto& a = x.as_f64vec();
+        auto& b = y.as_f64vec();
+        if(a.size() != b.size()){
+            throw Error(env, "vector length mismatch");
+        }
+        return Object(simd::dot(a.data(), b.data(), a.size()));
+    }
+    auto a = reals(x);
+    auto b = reals(y);
+    if(a.size() != b.size()){
+        throw Error(env, "vector length mismatch");
+    }
+    return Object(simd::dot(a.data(), b.data(), a.size()));
+}
+
+// -*-
+// (min vecObj) | (min listObj) | (min n1 n2 ...)
+static Object extremum(std::vector<Object>& args, Env& env, bool lowest){
+    evaluate(args, env);
+
+    const char* message = lowest ? "Invalid 'min' expression." : "Invalid 'max' expression.";
+    if(args.size() == 1 && args[0].type()==Type::F64Vec){
+        auto& data = args[0].as_f64vec();
+        if(data.empty()){ throw Error(env, message); }
+        return Object(
+            lowest ? simd::min(data.data(), data.size()) : simd::max(data.data(), data.size())
         );
-        for(auto val: values){
-            result.emplace_back(Object(val));
+    }
+    if(args.size() == 1 && args[0].type()==Type::I64Vec){
+        auto& data = args[0].as_i64vec();
+        if(data.empty()){ throw Error(env, message); }
+        return Object(
+            lowest ? simd::min(data.data(), data.size()) : simd::max(data.data(), data.size())
+        );
+    }
+    auto items = (
+        args.size()==1 && (args[0].type()==Type::List || args[0].is_sequence()) ?
+        args[0].as_list() : args
+    );
+    if(items.empty()){
+        throw Error(env, message);
+    }
+    Object result = items[0];
+    for(size_t i=1; i < items.size(); i++){
+        if(lowest ? items[i] < result : result < items[i]){
+            result = items[i];
         }
     }
+    return result;
+}
 
-    return Object(result);
+// -*-
+static Object fun_min(std::vector<Object> args, Env& env){
+    return extremum(args, env, true);
+}
+
+// -*-
+static Object fun_max(std::vector<Object> args, Env& env){
+    return extremum(args, env, false);
+}
+
+// -*-
+// (hash-map key1 value1 key2 value2 ...)
+static Object fun_hash_map(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() % 2 != 0){
+        throw Error(env, "Invalid 'hash-map' expression: expect key/value pairs");
+    }
+    Object result = Object::create_hashmap();
+    auto& table = result.as_hashmap();
+    for(size_t i=0; i < args.size(); i += 2){
+        table.insert(args[i], args[i+1]);
+    }
+    return result;
+}
+
+// -*-
+// (hash-get hashObj key)
+// (hash-get hashObj key default)
+static Object fun_hash_get(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() < 2 || args.size() > 3 || !args[0].is_hashmap()){
+        throw Error(env, "Invalid 'hash-get' expression.");
+    }
+    auto value = args[0].as_hashmap().find(args[1]);
+    if(value != nullptr){
+        return *value;
+    }
+    if(args.size()==3){
+        return args[2];
+    }
+    throw Error(env, "hash-get: key not found");
+}
+
+// -*-
+// (hash-set! hashObj key value) => hashObj
+static Object fun_hash_set(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 3 || !args[0].is_hashmap()){
+        throw Error(env, "Invalid 'hash-set!' expression.");
+    }
+    args[0].as_hashmap().insert(args[1], args[2]);
+    return args[0];
+}
+
+// -*-
+// (hash-remove! hashObj key) => 1 if the key was present, 0 otherwise
+static Object fun_hash_remove(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 2 || !args[0].is_hashmap()){
+        throw Error(env, "Invalid 'hash-remove!' expression.");
+    }
+    return Object(static_cast<long>(args[0].as_hashmap().erase(args[1])));
+}
+
+// -*-
+// (hash-contains? hashObj key)
+static Object fun_hash_contains(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 2 || !args[0].is_hashmap()){
+        throw Error(env, "Invalid 'hash-contains?' expression.");
+    }
+    return Object(static_cast<long>(args[0].as_hashmap().find(args[1]) != nullptr));
+}
+
+// -*-
+// (hash-keys hashObj) ; also accepts a pmap
+static Object fun_hash_keys(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1 || !(args[0].is_hashmap() || args[0].is_pmap())){
+        throw Error(env, "Invalid 'hash-keys' expression.");
+    }
+    if(args[0].is_pmap()){
+        return Object(args[0].as_pmap().keys());
+    }
+    return Object(args[0].as_hashmap().keys());
+}
+
+// -*-
+// (hash-values hashObj)
+static Object fun_hash_values(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1 || !(args[0].is_hashmap() || args[0].is_pmap())){
+        throw Error(env, "Invalid 'hash-values' expression.");
+    }
+    if(args[0].is_pmap()){
+        return Object(args[0].as_pmap().values());
+    }
+    return Object(args[0].as_hashmap().values());
+}
+
+// -*-
+// (hash-items hashObj) => ((key value) ...)
+static Object fun_hash_items(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1 || !(args[0].is_hashmap() || args[0].is_pmap())){
+        throw Error(env, "Invalid 'hash-items' expression.");
+    }
+    if(args[0].is_pmap()){
+        return Object(args[0].as_pmap().items());
+    }
+    return Object(args[0].as_hashmap().items());
+}
+
+// -*-
+// (pvec x1 x2 ...)
+static Object fun_pvec(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    PersistentVector result;
+    for(auto& item: args){
+        result = result.push_back(item);
+    }
+    return Object::create_pvec(result);
+}
+
+// -*-
+// (pmap key1 value1 key2 value2 ...)
+static Object fun_pmap(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() % 2 != 0){
+        throw Error(env, "Invalid 'pmap' expression: expect key/value pairs");
+    }
+    PersistentMap result;
+    for(size_t i=0; i < args.size(); i += 2){
+        result = result.set(args[i], args[i+1]);
+    }
+    return Object::create_pmap(result);
+}
+
+// -*-
+// (list->pvec listObj)
+static Object fun_list_to_pvec(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1){
+        throw Error(env, "Invalid 'list->pvec' expression.");
+    }
+    PersistentVector result;
+    for(auto& item: args[0].as_list()){
+        result = result.push_back(item);
+    }
+    return Object::create_pvec(result);
+}
+
+// -*-
+// (pvec->list pvecObj)
+static Object fun_pvec_to_list(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1 || !args[0].is_pvec()){
+        throw Error(env, "Invalid 'pvec->list' expression.");
+    }
+    return Object(args[0].as_pvec().to_list());
+}
+
+// -*-
+// (butlast pvecObj) | (butlast listObj): everything but the last element
+static Object fun_butlast(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 1){
+        throw Error(env, "Invalid 'butlast' expression.");
+    }
+    if(args[0].is_pvec()){
+        return Object::create_pvec(args[0].as_pvec().pop_back());
+    }
+    auto data = args[0].as_list();
+    if(data.empty()){
+        throw Error(env, "index out of range");
+    }
+    data.pop_back();
+    return Object(data);
+}
+
+// -*-
+// (assoc pvecObj i value) | (assoc pmapObj key value) => updated copy
+static Object fun_assoc(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 3){
+        throw Error(env, "Invalid 'assoc' expression.");
+    }
+    if(args[0].is_pvec()){
+        auto idx = args[1].as_integer();
+        if(idx < 0){
+            throw Error(env, "index out of range");
+        }
+        return Object::create_pvec(args[0].as_pvec().set(idx, args[2]));
+    }
+    if(args[0].is_pmap()){
+        return Object::create_pmap(args[0].as_pmap().set(args[1], args[2]));
+    }
+    throw Error(env, ErrorKind::TypeError);
+}
+
+// -*-
+// (dissoc pmapObj key) => copy without key
+static Object fun_dissoc(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 2 || !args[0].is_pmap()){
+        throw Error(env, "Invalid 'dissoc' expression.");
+    }
+    return Object::create_pmap(args[0].as_pmap().erase(args[1]));
+}
+
+// -*-
+// (get pmapObj key [default]) | (get hashObj key [default]) | (get pvecObj i [default])
+static Object fun_get(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() < 2 || args.size() > 3){
+        throw Error(env, "Invalid 'get' expression.");
+    }
+    const Object* value = nullptr;
+    if(args[0].is_pmap()){
+        value = args[0].as_pmap().find(args[1]);
+    }else if(args[0].is_hashmap()){
+        value = args[0].as_hashmap().find(args[1]);
+    }else if(args[0].is_pvec()){
+        auto idx = args[1].as_integer();
+        auto& data = args[0].as_pvec();
+        if(idx >= 0 && static_cast<size_t>(idx) < data.size()){
+            value = &data.at(idx);
+        }
+    }else{
+        throw Error(env, ErrorKind::TypeError);
+    }
+    if(value != nullptr){
+        return *value;
+    }
+    if(args.size() == 3){
+        return args[2];
+    }
+    throw Error(env, "get: key not found");
+}
+
+// -*-
+// (contains? pmapObj key) | (contains? hashObj key)
+static Object fun_containsp(std::vector<Object> args, Env& env){
+    evaluate(args, env);
+
+    if(args.size() != 2){
+        throw Error(env, "Invalid 'contains?' expression.");
+    }
+    if(args[0].is_pmap()){
+        return Object(static_cast<long>(args[0].as_pmap().find(args[1]) != nullptr));
+    }
+    if(args[0].is_hashmap()){
+        return Object(static_cast<long>(args[0].as_hashmap().find(args[1]) != nullptr));
+    }
+    throw Error(env, ErrorKind::TypeError);
 }
 
 // -*--------------------------------------------------------------------*-
 // -*- Runtime                                                          -*-
 // -*--------------------------------------------------------------------*-
-Object Runtime::execute(std::string source, Env& env){
-    Parser parser(source);
+Object Runtime::execute(std::string source, Env& env, const std::string& filename){
+    return Runtime::execute(std::move(source), env, Runtime::limits, filename);
+}
+
+// -*-
+Object Runtime::execute(std::string source, Env& env, const Limits& limits, const std::string& filename){
+    Budget budget(limits);
+    Parser parser(source, filename);
     auto result = parser.parse();
+    if(result.empty()){
+        return Object();
+    }
     for(size_t i=0; i < result.size()-1; i++){
+        TraceScope scope(traced(result[i]), "toplevel", result[i].span());
         result[i].eval(env);
     }
-    return result[result.size()-1].eval(env);
+    TraceScope scope(traced(result.back()), "toplevel", result.back().span());
+    return result.back().eval(env);
 }
 
 // -*-
@@ -1033,6 +2313,12 @@ static void help(){
     std::cout << ":help     Print this message\n";
     std::cout << ":whos     Print all variables currently in the local environment\n";
     std::cout << ":global   Print all symbols in the global environment\n";
+    std::cout << ":stats    Print call counts and times per function;\n";
+    std::cout << "          ':stats on', ':stats off' and ':stats reset' control collection\n";
+    std::cout << ":allocs   Print object copies and list, string and env allocations\n";
+    std::cout << "          per function; ':allocs on', ':allocs off' and ':allocs reset'\n";
+    std::cout << ":nodes    Print execution counts and value types per source location;\n";
+    std::cout << "          ':nodes on', ':nodes off' and ':nodes reset'\n";
     std::cout << ":clear    Clear all variables currently in the local environment\n";
     std::cout << ":export   Request the writing all expressions currently in\n";
     std::cout << "          the environment to a file\n";
@@ -1067,10 +2353,10 @@ void whos(const std::map<std::string, Object>& bindings){
     auto show = [](std::string key, Object val){
         std::cout << " " << std::setw(10) << key << " |";
         std::cout << " " << std::setw(16) << val.str() << " | ";
-        auto size = sizeof(val);
+        auto size = val.memory_size();
         std::cout << size << " bytes" << std::endl;
     };
-    for(auto [key, val]: bindings){
+    for(const auto& [key, val]: bindings){
         show(key, val);
     }
 }
@@ -1110,7 +2396,9 @@ void Runtime::repl(Env& env){
     localEnv.set_parent(self);
     while(true){
         std::cout << ">>> ";
-        std::getline(std::cin, input);
+        if(!std::getline(std::cin, input)){
+            break;
+        }
         if(input==":quit" || input==":bye" || input==":exit" || input==":q"){
             break;
         }else if(input==":help" || input==":h"){
@@ -1119,6 +2407,24 @@ void Runtime::repl(Env& env){
             whos(localEnv.bindings());
         }else if(input==":clear"){
             clear(localEnv);
+        }else if(input==":stats"){
+            Stats::print(std::cout);
+        }else if(input==":stats on" || input==":stats off"){
+            Stats::enable(input==":stats on");
+        }else if(input==":stats reset"){
+            Stats::reset();
+        }else if(input==":allocs"){
+            Accounting::print(std::cout);
+        }else if(input==":allocs on" || input==":allocs off"){
+            Accounting::enable(input==":allocs on");
+        }else if(input==":allocs reset"){
+            Accounting::reset();
+        }else if(input==":nodes"){
+            NodeProfile::print(std::cout);
+        }else if(input==":nodes on" || input==":nodes off"){
+            NodeProfile::enable(input==":nodes on");
+        }else if(input==":nodes reset"){
+            NodeProfile::reset();
         }else if(input==":global"){
             gloabl(localEnv);
         }else if(input==":export"){
@@ -1139,8 +2445,10 @@ void Runtime::repl(Env& env){
 
 // -*-
 Env Runtime::builtins = Env();
+size_t Runtime::recursion_limit = 100000;
+Limits Runtime::limits = Limits();
 
-static Env swzlisp_init(){
+Env swzlisp_init(){
     Env env{};
 #define SWZLISP_DEF(name, fname) { name, Object(name, fun##fname) },
     
@@ -1157,69 +2465,6 @@ static Env swzlisp_init(){
     return env;
 }
 
-// -*-
-// ./prog
-// ./prog -h
-// ./prog -i
-// ./prog -f filename
-// ./prog -c sexpr
-
-
-static std::string progname;
-
-static void usage(){
-    std::string help = progname + " [-h]|[-i]|[-c sexpr]|[-f filename]\n";
-    std::cout << help << std::endl;
-    std::cout << "Options:\n";
-    std::cout << "     -h              Print this message\n";
-    std::cout << "     -i              Enter interactive mode\n";
-    std::cout << "     -c sexpr        Run 'sexpr'\n";
-    std::cout << "     -f script       Run 'scipt' in batch mode" << std::endl;
-}
-
 // -*--------------------------------------------------------------------*-
 }//-*- end::namespace::swzlisp                                          -*-
 // -*--------------------------------------------------------------------*-
-
-static void sighandler(int sig){
-    if(sig==SIGINT || sig==SIGTERM){
-        std::exit(EXIT_SUCCESS);
-    }
-}
-
-// -*-------------------------*-
-// -*- M A I N   D R I V E R -*-
-// -*-------------------------*-
-int main(int argc, char **argv){
-    std::signal(SIGINT, sighandler);
-    std::signal(SIGTERM, sighandler);    
-    swzlisp::Runtime::builtins = swzlisp::swzlisp_init();
-    swzlisp::Env workspace(swzlisp::Runtime::builtins);
-    std::vector<swzlisp::Object> args;
-    for(int i=0; i < argc; i++){
-        args.emplace_back(swzlisp::Object::create_string(std::string(argv[i])));
-    }
-    swzlisp::Object self(args);
-    workspace.put(":argv", self);
-
-    try{
-        if(argc == 1 || (argc==2 && std::string(argv[1]) == "-i")){
-            swzlisp::Runtime::repl(workspace);
-        }else if(argc == 2 && std::string(argv[1])=="-h"){
-            swzlisp::help();
-        }else if(argc==3 && std::string(argv[1])=="-c"){
-            std::string sexpr(argv[2]);
-            swzlisp::Runtime::execute(sexpr, workspace);
-        }else if(argc==3 && std::string(argv[1])=="-f"){
-            std::string filename(argv[2]);
-            std::string source = swzlisp::Runtime::read_file(filename);
-            swzlisp::Runtime::execute(source, workspace);
-        }
-    }catch(swzlisp::Error& err){
-        std::cerr << err.describe() << std::endl;
-    }catch(std::exception& err){
-        std::cerr << err.what() << std::endl;
-    }
-
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
@@ -13,18 +13,32 @@
 #include<vector>
 #include<random>
 #include<string>
+#include<cstdint>
 #include<cmath>
+#include<atomic>
+#include<list>
 #include<map>
+#include<unordered_map>
+#include<unordered_set>
 
 #define SWZLISP_TYPES               \
     SWZLISP_DEF(Unit, "unit")       \
     SWZLISP_DEF(Atom, "atom")       \
     SWZLISP_DEF(Quote, "quote")     \
     SWZLISP_DEF(Integer, "integer") \
+    SWZLISP_DEF(Bignum, "integer")  \
     SWZLISP_DEF(Float, "float")     \
     SWZLISP_DEF(String, "string")   \
     SWZLISP_DEF(List, "list")       \
+    SWZLISP_DEF(F64Vec, "f64vec")   \
+    SWZLISP_DEF(I64Vec, "i64vec")   \
+    SWZLISP_DEF(HashMap, "hash-map") \
+    SWZLISP_DEF(PVec, "pvec")       \
+    SWZLISP_DEF(PMap, "pmap")       \
+    SWZLISP_DEF(Transient, "transient") \
+    SWZLISP_DEF(Sequence, "sequence") \
     SWZLISP_DEF(Lambda, "function") \
+    SWZLISP_DEF(Macro, "macro")     \
     SWZLISP_DEF(Builtin, "function")
 
 #define SWZLISP_EXCEPTIONS                              \
@@ -70,67 +84,404 @@ static std::map<ErrorKind, std::string> swzlispExceptions = {
 // is_symbol() | is_valid_char()
 
 class Object;
+class Env;
+
+// -*-
+// Source position of a parsed atom, packed in eight bytes; a list is located
+// by its head atom. File names are interned once and referred to by index.
+struct Span{
+    std::uint32_t line = 0;         // 1-based, 0 when unknown
+    std::uint16_t column = 0;       // 1-based, saturates at 65535
+    std::uint16_t file = 0;         // index into the interned file names
+
+    bool known() const { return this->line != 0; }
+    std::string str() const;        // "file:line:column"
+    static std::uint16_t intern(const std::string& filename);
+};
+
+// -*-
+// Per-site cache attached to an atom: remembers the frame and the slot the
+// name resolved to. A hit costs one pointer and one version compare.
+// The atom's source span rides along, so parsed code carries its positions
+// without growing Object.
+struct InlineCache{
+    Span span;
+    const Env* frame = nullptr;
+    std::uint64_t version = 0;
+    const Object* slot = nullptr;
+    std::uint64_t bits = 0;         // bloom bits of the cached name
+    // When the atom heads a macro call: the expansion of that form, valid
+    // while both the macro and the form's elements are the ones it came from.
+    std::weak_ptr<const void> macro;
+    std::weak_ptr<const void> form;
+    size_t offset = 0;
+    std::shared_ptr<const Object> expansion;
+    // Execution profile, kept while NodeProfile is enabled: how often the
+    // node ran and one bit per Type of the values it produced.
+    std::uint64_t count = 0;
+    std::uint32_t types = 0;
+    // When the atom heads a call: the dispatch eval() settled on. A site
+    // starts Cold; once hot, a call to one of the arithmetic builtins with
+    // two arguments speculates on integers until its guards miss too often.
+    enum Path: std::uint8_t{
+        Cold, Generic, Add, Sub, Mul, Less, Greater, LessEqual, GreaterEqual, Equal
+    };
+    Path path = Cold;
+    std::uint8_t misses = 0;
+    std::uint16_t heat = 0;
+};
+
 // -*-
 //template<typename T>
 class Env: public std::enable_shared_from_this<Env>{
 public:
     Env();
     Env(const Env&);
+    Env& operator=(const Env&);
     bool contains(const std::string& name) const;
-    const Object& get(std::string name) const;
-    void put(std::string name, Object& value);
+    const Object& get(const std::string& name) const;
+    const Object& lookup(const std::string& name, InlineCache& cache) const;
+    // Binding slot for in-place updates. The slot's address is unchanged,
+    // so inline caches that point at it stay valid.
+    Object& binding(const std::string& name);
+    void put(const std::string& name, const Object& value);
 
     void merge(const Env& other);
 
+    // Frames that are not owned by a shared_ptr (the workspace, lambda
+    // frames) hand out a non-owning pointer valid for the call's duration.
     std::shared_ptr<Env> get_pointer(){
-        return shared_from_this();
+        auto self = this->weak_from_this().lock();
+        if(self == nullptr){
+            self = std::shared_ptr<Env>(std::shared_ptr<Env>(), this);
+        }
+        return self;
     }
     
     void set_parent(const std::shared_ptr<Env>& parent){
         this->m_parent = parent;
     }
+    // Links a call frame to its caller. Scoping is dynamic, so deep
+    // recursion stacks up call frames between a body and the globals;
+    // lookup() skips them at once when none can bind the name.
+    void set_caller(const std::shared_ptr<Env>& caller);
 
     friend std::ostream& operator<<(std::ostream& out, const Env&);
 
+    size_t memory_size(std::unordered_set<const void*>& seen) const;   // this frame only
     std::map<std::string, Object> bindings() const{
         return this->m_bindings;
     }
 
     void clear(){
         this->m_bindings.clear();
+        this->m_mask = 0;           // m_calls_mask may keep stale bits
+        this->m_version = ++Env::s_clock;
     }
 
     std::shared_ptr<Env> parent() const {
         return this->m_parent;
     }
 
+    std::uint64_t version() const { return this->m_version; }
+
+    // Two bits per name: frames of a recursive call bind the same few
+    // names, and a name colliding with one of them on a single bit would
+    // be looked for in every frame.
+    static std::uint64_t name_bits(const std::string& name){
+        auto hash = std::hash<std::string>{}(name);
+        return (std::uint64_t(1) << (hash & 63)) | (std::uint64_t(1) << ((hash >> 6) & 63));
+    }
+
 private:
     std::map<std::string, Object> m_bindings;
     std::shared_ptr<Env> m_parent;
+    // Every binding change draws a fresh stamp from a global clock so a
+    // cache can never match a reused frame address.
+    std::uint64_t m_version;
+    std::uint64_t m_mask;           // bloom filter of the bound names
+    // Call frames: m_mask of this frame and the call frames above it, and
+    // the nearest enclosing frame that is not one. Other frames: 0 and this.
+    std::uint64_t m_calls_mask;
+    const Env* m_outer;
+    static std::uint64_t s_clock;
 };
 
 // -*-
-//template<typename T>
+// Errors are cheap to throw and copy: a kind, a message, and a weak
+// reference to the frame that raised them, which is empty once that frame
+// is gone or when it was never owned by a shared_ptr.
 class Error {
 public:
     Error();
     Error(const Env& env, ErrorKind);
     Error(const Env& env, const char *message);
-    Error(const Error& other);
+    Error(ErrorKind kind, std::string message);
+    Error(const Error& other) = default;
     ~Error() = default;
 
-    std::string describe();
+    std::string describe() const;
+    ErrorKind kind() const { return this->m_error; }
+    std::string message() const;                // default text if none given
+    std::shared_ptr<const Env> frame() const { return this->m_frame.lock(); }
+    const Span& span() const { return this->m_span; }
+    void locate(const Span& span){ this->m_span = span; }
 
 private:
     ErrorKind m_error;
-    //std::shared_ptr<Object> m_reason;
-    Env m_env;
     std::string m_message;
+    std::weak_ptr<const Env> m_frame;
+    Span m_span;                                // innermost located form
 };
 
+// -*-
+// Arbitrary precision integer in sign-magnitude form. Integers only take
+// this representation once a fixnum operation overflows.
+class Bignum{
+public:
+    Bignum();
+    explicit Bignum(long value);
+    static Bignum parse(const std::string& text);
+
+    bool is_zero() const { return this->m_limbs.empty(); }
+    bool is_negative() const { return this->m_negative; }
+    bool fits_long() const;
+    long to_long() const;
+    double to_double() const;
+    std::string str() const;
+    size_t hash() const;
+    size_t memory_size() const{
+        return sizeof(Bignum) + this->m_limbs.capacity()*sizeof(std::uint32_t);
+    }
+
+    int compare(const Bignum& other) const;
+    Bignum operator-() const;
+    Bignum operator+(const Bignum& other) const;
+    Bignum operator-(const Bignum& other) const;
+    Bignum operator*(const Bignum& other) const;
+    Bignum operator/(const Bignum& other) const;
+    Bignum operator%(const Bignum& other) const;
+
+private:
+    bool m_negative;
+    std::vector<std::uint32_t> m_limbs;   // least significant limb first
+
+    std::uint64_t magnitude() const;
+};
+
+// -*-
+// Kernels behind f64vec and i64vec. Each entry point runs an AVX2 body when
+// the CPU supports it and a scalar loop otherwise. An operand flagged as
+// scalar is broadcast from its first element.
+namespace simd{
+enum class Op{ Add, Sub, Mul, Div };
+enum class Cmp{ Eq, Ne, Lt, Gt, Le, Ge };
+
+bool has_avx2();
+void binary(Op op, const double* x, bool xs, const double* y, bool ys, double* z, size_t n);
+void binary(Op op, const long* x, bool xs, const long* y, bool ys, long* z, size_t n);
+void compare(Cmp cmp, const double* x, bool xs, const double* y, bool ys, long* z, size_t n);
+void compare(Cmp cmp, const long* x, bool xs, const long* y, bool ys, long* z, size_t n);
+double sum(const double* x, size_t n);
+long sum(const long* x, size_t n);
+double dot(const double* x, const double* y, size_t n);
+long dot(const long* x, const long* y, size_t n);
+double min(const double* x, size_t n);
+double max(const double* x, size_t n);
+long min(const long* x, size_t n);
+long max(const long* x, size_t n);
+}
+
 class Object;
+class HashMap;
+class PersistentVector;
+class PersistentMap;
+class MemoCache;
+class Sequence;
+class Iterator;
 typedef Object (*Fun)(std::vector<Object>, Env&);
 
+// -*-
+// Function names as the profiler sees them. Each distinct name is stored
+// once and never freed, so a stack frame is a single pointer.
+typedef const std::string* FrameName;
+FrameName intern_name(const std::string& name);
+
+// -*-
+// Functions being applied on the interpreter thread, innermost last. apply()
+// pushes and pops a frame around every lambda and builtin; the profiler reads
+// the stack from a signal handler, so frames are plain pointers and frames
+// past CAPACITY are counted but not stored.
+class CallStack{
+public:
+    static constexpr size_t CAPACITY = 1024;
+
+    static void push(FrameName name){
+        size_t depth = s_depth;
+        if(depth < CAPACITY){
+            s_frames[depth] = name;
+        }
+        std::atomic_signal_fence(std::memory_order_release);
+        s_depth = depth + 1;
+    }
+    static void pop(){ s_depth = s_depth - 1; }
+    static size_t depth(){ return s_depth; }
+    static FrameName at(size_t i){ return s_frames[i]; }
+
+private:
+    static FrameName s_frames[CAPACITY];
+    static volatile size_t s_depth;
+};
+
+// -*-
+// Copy and allocation counters, charged to the function on top of the
+// CallStack. Collection is off by default; the hooks in the hot paths then
+// cost a single test of a flag.
+class Accounting{
+public:
+    enum Event{ ObjectCopy, ListAlloc, StringAlloc, EnvCopy, NEVENTS };
+    struct Entry{
+        std::string name;
+        std::uint64_t counts[NEVENTS];
+    };
+
+    static bool enabled(){ return s_enabled; }
+    static void enable(bool flag);
+    static void reset();
+    static void record(Event event){
+        if(__builtin_expect(s_enabled, false)){
+            Accounting::count(event);
+        }
+    }
+    static std::vector<Entry> entries();    // by total count, largest first
+    static void print(std::ostream& out);
+
+private:
+    static bool s_enabled;
+    static void count(Event event);
+};
+
+// -*-
+// Sampling profiler: a SIGPROF timer copies the call stack into a buffer
+// reserved up front; samples that do not fit are dropped and counted. The
+// samples are written in the collapsed format read by flamegraph tools,
+// one "outer;...;inner count" line per distinct stack.
+class Profiler{
+public:
+    static constexpr unsigned MAX_HERTZ = 100000;
+
+    static void start(unsigned hertz=1000);
+    static void stop();
+    static bool running();
+    static size_t samples();
+    static size_t dropped();
+    static void write_folded(std::ostream& out);
+};
+
+// -*-
+// Call counts and times per function, gathered by apply() while enabled.
+// Inclusive time runs from entry to exit; exclusive time leaves out the
+// callees. Disabled, the cost per call is one test of a flag.
+class Stats{
+public:
+    struct Entry{
+        std::string name;
+        std::uint64_t calls;
+        double inclusive;           // seconds
+        double exclusive;           // seconds
+    };
+
+    static bool enabled(){ return s_enabled; }
+    static void enable(bool flag);
+    static void reset();
+    static void enter();
+    static void leave(FrameName name);
+    static std::vector<Entry> entries();    // by exclusive time, largest first
+    static void print(std::ostream& out);
+
+private:
+    static bool s_enabled;
+};
+
+// -*-
+// Timeline of an evaluation in the Chrome trace-event format, as read by
+// Perfetto and chrome://tracing. Top-level forms, imports and file I/O are
+// always recorded; user function calls only when they last at least the
+// threshold. Each thread writes complete events into its own ring buffer,
+// overwriting the oldest when full, and write_json() emits them once
+// tracing has stopped.
+class Tracer{
+public:
+    static void start(double threshold_us=100.0);
+    static void stop();
+    static bool enabled(){ return s_enabled; }
+    static std::uint64_t now();                             // steady clock, ns
+    static std::uint64_t threshold(){ return s_threshold; } // ns
+    static void record(
+        FrameName name, const char* category,
+        std::uint64_t start, std::uint64_t end, const Span& span);
+    static size_t events();
+    static size_t dropped();
+    static void write_json(std::ostream& out);
+
+private:
+    static bool s_enabled;
+    static std::uint64_t s_threshold;
+};
+
+// -*-
+// Traces the enclosing block as one event. A filtered scope is kept only
+// when it lasts at least Tracer::threshold().
+class TraceScope{
+public:
+    TraceScope(FrameName name, const char* category, const Span& span=Span(), bool filtered=false)
+    : m_name{name}, m_category{category}, m_span{span}, m_filtered{filtered},
+      m_start{Tracer::enabled() ? Tracer::now() : 0}{}
+    ~TraceScope(){
+        if(this->m_start != 0){
+            auto end = Tracer::now();
+            if(!this->m_filtered || end - this->m_start >= Tracer::threshold()){
+                Tracer::record(this->m_name, this->m_category, this->m_start, end, this->m_span);
+            }
+        }
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    FrameName m_name;
+    const char* m_category;
+    Span m_span;
+    bool m_filtered;
+    std::uint64_t m_start;
+};
+
+// -*-
+// Per-node execution counts for profile-guided work. While enabled, eval()
+// counts every variable read and every call headed by an atom on that
+// atom's inline cache, together with the types of the values produced;
+// the report is keyed by source location. Disabled, the cost per node is
+// one test of a flag.
+class NodeProfile{
+public:
+    struct Entry{
+        std::string location;
+        std::string node;                   // "x" for a read, "(f ...)" for a call
+        std::uint64_t count;
+        std::vector<std::string> types;
+        std::string path;                   // calls: the dispatch in use
+    };
+
+    static bool enabled(){ return s_enabled; }
+    static void enable(bool flag);
+    static void reset();
+    static void record(const std::shared_ptr<InlineCache>& node, const std::string& name, bool call, Type type);
+    static std::vector<Entry> entries();    // by count, largest first
+    static void print(std::ostream& out);
+
+private:
+    static bool s_enabled;
+};
 
 // -*-
 class Object: public std::enable_shared_from_this<Object>{
@@ -143,22 +494,46 @@ public:
     Object(std::string, Fun);                                                   // Type::Builtin
     
     Object(const Object& other){
+        Accounting::record(Accounting::ObjectCopy);
         this->m_type = other.m_type;
         this->m_value = other.m_value;
     }
 
     Object& operator=(const Object& other){
         if(this!=&other){
+            Accounting::record(Accounting::ObjectCopy);
             this->m_type = other.m_type;
             this->m_value = other.m_value;
         }
         return *this;
     }
 
+    Object(Object&& other) noexcept
+    : m_type{other.m_type}, m_value{std::move(other.m_value)}{}
+
+    Object& operator=(Object&& other) noexcept{
+        if(this!=&other){
+            this->m_type = other.m_type;
+            this->m_value = std::move(other.m_value);
+        }
+        return *this;
+    }
+
     // -
     static Object create_quote(Object obj);                                     // Quote
     static Object create_atom(std::string str);                                 // Atom
     static Object create_string(std::string str);                               // String
+    static Object create_integer(const Bignum& value);                          // Integer, Bignum
+    static Object create_f64vec(std::vector<double> data);                      // F64Vec
+    static Object create_i64vec(std::vector<long> data);                        // I64Vec
+    static Object create_hashmap();                                             // HashMap
+    static Object create_pvec(const PersistentVector& data);                   // PVec
+    static Object create_pmap(const PersistentMap& data);                      // PMap
+    static Object create_transient(std::vector<Object> items);                  // Transient
+    static Object create_sequence(std::shared_ptr<const Sequence> seq);         // Sequence
+    static Object create_macro(std::vector<Object> params, Object body, const Env& env); // Macro
+    Object memoize(size_t capacity) const;                                      // Lambda
+    Object named(const std::string& name) const;                                // Lambda, Macro
 
     // -*-
     std::shared_ptr<Object> get_pointer(){
@@ -168,36 +543,80 @@ public:
 
     Type type() const{ return this->m_type; }
     bool is_integer() const { return this->m_type==Type::Integer; }
+    bool is_bignum() const { return this->m_type==Type::Bignum; }
+    bool is_vector() const {
+        return this->m_type==Type::F64Vec || this->m_type==Type::I64Vec;
+    }
     bool is_float() const { return this->m_type==Type::Float; }
+    bool is_hashmap() const { return this->m_type==Type::HashMap; }
+    bool is_pvec() const { return this->m_type==Type::PVec; }
+    bool is_pmap() const { return this->m_type==Type::PMap; }
+    bool is_transient() const { return this->m_type==Type::Transient; }
+    bool is_sequence() const { return this->m_type==Type::Sequence; }
+    bool is_iterable() const;
     bool is_string() const { return this->m_type==Type::String; }
 
     // -*-
     std::vector<std::string> atoms();
     bool is_builtin() const;
-    Object apply(std::vector<Object> args, Env& env);
-    Object eval(Env& env);
+    bool is_macro() const { return this->m_type==Type::Macro; }
+    std::shared_ptr<MemoCache> memo_cache() const;  // null unless memoized
+    Object macroexpand(Env& env) const;         // one expansion step, or *this
+    Span span() const;                          // where an atom or form was parsed
+    // Bytes reachable from this object: the Object itself plus every heap
+    // block it owns or shares. Blocks already in seen are not counted again.
+    size_t memory_size() const;
+    size_t memory_size(std::unordered_set<const void*>& seen) const;
+    // a vector's storage plus what its elements own
+    static size_t memory_size(const std::vector<Object>& items, std::unordered_set<const void*>& seen);
+    void locate(const Span& span);              // atoms only
+    Object apply(std::vector<Object> args, Env& env) const;
+    Object eval(Env& env) const;
     bool is_number() const;
     bool as_boolean() const;
     long as_integer() const;
     double as_float() const;
+    Bignum as_bignum() const;
+    const std::vector<double>& as_f64vec() const;
+    const std::vector<long>& as_i64vec() const;
+    HashMap& as_hashmap() const;
+    const PersistentVector& as_pvec() const;
+    const PersistentMap& as_pmap() const;
+    const Sequence& as_sequence() const;
+    std::unique_ptr<Iterator> iterate() const;      // elements, or keys of a map
     std::string as_string() const;
     std::string as_atom() const;
-    std::vector<Object> as_list() const;
+    std::vector<Object> as_list() const;                                        // also realizes a Sequence
+    size_t list_size() const;                                                   // O(1), also Transient
+    const Object& list_at(size_t index) const;                                  // O(1), also Transient
+    Object slice(size_t start, size_t stop) const;                              // O(1) view
+    // In-place updates of a List (copy-on-write) or a Transient
     void push(Object obj);
     Object pop();
+    void insert(size_t index, Object obj);
+    Object remove(size_t index);
+    void set(size_t index, Object obj);
+    Object freeze();                                                            // Transient -> List
     Object to_integer() const;
     Object to_float() const;
-    bool operator==(Object other) const;
-    bool operator!=(Object other) const;
-    bool operator>=(Object other) const;
-    bool operator<=(Object other) const;
-    bool operator>(Object other) const;
-    bool operator<(Object other) const;
-    Object operator+(Object other) const;
-    Object operator-(Object other) const;
-    Object operator*(Object other) const;
-    Object operator/(Object other) const;
-    Object operator%(Object other) const;
+    size_t hash() const;
+    static size_t hash(const std::vector<Object>& items);
+    bool operator==(const Object& other) const;
+    bool operator!=(const Object& other) const;
+    int compare(const Object& other) const;     // <0, 0, >0
+    bool operator>=(const Object& other) const;
+    bool operator<=(const Object& other) const;
+    bool operator>(const Object& other) const;
+    bool operator<(const Object& other) const;
+    Object operator+(const Object& other) const;
+    Object operator-(const Object& other) const;
+    Object operator*(const Object& other) const;
+    Object operator/(const Object& other) const;
+    Object operator%(const Object& other) const;
+    static Object sum(const std::vector<Object>& args);                         // (+ ...)
+    static Object difference(const std::vector<Object>& args);                  // (- ...)
+    static Object product(const std::vector<Object>& args);                     // (* ...)
+    Object elementwise(simd::Cmp cmp, const Object& other) const;              // (vec< ...)
     std::string type_name();
     std::string str();
     std::string repr();
@@ -206,29 +625,90 @@ public:
 
 private:
     // long -> Integer
+    // Bignum -> Bignum
     // double -> Float
-    // std::string -> String, Atom
+    // std::string -> String
+    // Symbol -> Atom
     // Fun -> Builtin
-    // std::vector<Object> -> List, Lambda, Quote
+    // Closure -> Lambda, Macro
+    // Slice -> List, Quote
+    // std::vector<double> -> F64Vec
+    // std::vector<long> -> I64Vec
+    // HashMap -> HashMap
+    // PersistentVector -> PVec
+    // PersistentMap -> PMap
+    // Transient -> Transient
+    // Sequence -> Sequence
     Type m_type;
     typedef std::vector<Object> List;
+    // List values are windows on a shared buffer, so slicing never copies.
+    // Writers go through mutable_list(), which copies the window first
+    // unless this object is the buffer's sole owner and sees all of it.
+    struct Slice{
+        std::shared_ptr<List> buffer;
+        size_t offset;
+        size_t length;
+
+        const Object* begin() const { return buffer->data() + offset; }
+        const Object* end() const { return this->begin() + length; }
+        size_t size() const { return length; }
+        const Object& operator[](size_t i) const { return (*buffer)[offset + i]; }
+    };
     struct Builtin{
         std::string name;
         Fun fun;
+        FrameName frame;                    // interned name
     };
     struct Lambda{
         List params;
         std::shared_ptr<Object> body;
         Env env; // lambda
+        std::shared_ptr<MemoCache> memo;    // results by arguments, if memoized
+        FrameName name = nullptr;           // set by defun, defmacro...
+    };
+    // Closures are immutable once built, so copies of a function share them.
+    typedef std::shared_ptr<const Lambda> Closure;
+    struct Symbol{
+        std::string name;
+        std::shared_ptr<InlineCache> cache;
     };
     
-    typedef std::variant<long, double, std::string, Lambda, Builtin, List> Value;
+    typedef std::shared_ptr<const Bignum> BignumPtr;
+    typedef std::shared_ptr<const std::vector<double>> F64Ptr;
+    typedef std::shared_ptr<const std::vector<long>> I64Ptr;
+    // Hash maps are mutable and shared: every copy sees the same table.
+    typedef std::shared_ptr<HashMap> HashMapPtr;
+    typedef std::shared_ptr<const PersistentVector> PVecPtr;
+    typedef std::shared_ptr<const PersistentMap> PMapPtr;
+    // A transient list is built in place through every reference to it
+    // and turned into an ordinary list by freeze(), after which it rejects
+    // further writes.
+    struct Transient{
+        List items;
+        bool frozen = false;
+    };
+    typedef std::shared_ptr<Transient> TransientPtr;
+    typedef std::shared_ptr<const Sequence> SequencePtr;
+    typedef std::variant<
+        long, double, std::string, Closure, Builtin, Slice, Symbol, BignumPtr,
+        F64Ptr, I64Ptr, HashMapPtr, PVecPtr, PMapPtr, TransientPtr, SequencePtr
+    > Value;
     
     Value m_value;
 
+    std::string vector_repr() const;
+    std::shared_ptr<const Object> expansion(const Object& macro, InlineCache& cache, Env& env) const;
+    bool specialized(const Object& fun, InlineCache& site, Env& env, Object& result) const;
+    std::string hashmap_repr() const;
+    std::string persistent_repr() const;
+    List& mutable_list();
+    List& writable();
+    void sync_length();
+    static Slice make_slice(List items);
+
     // -*-
-    void unwrap(Lambda& value){
-        value = std::get<Lambda>(m_value);
+    void unwrap(Closure& value){
+        value = std::get<Closure>(m_value);
     }
     // -*-
     void unwrap(long& value){
@@ -252,10 +732,180 @@ private:
     
     // -*-
     void unwrap(List& value){
-        value = std::get<List>(m_value);
+        const Slice& slice = std::get<Slice>(m_value);
+        value.assign(slice.begin(), slice.end());
     }
 };
 
+// -*-
+// Cursor over an iterable value. next() stores the following element in
+// `out` and returns false once the elements are exhausted.
+class Iterator{
+public:
+    virtual ~Iterator() = default;
+    virtual bool next(Object& out) = 0;
+};
+
+// -*-
+// Lazily generated, immutable sequence. Elements are produced on demand by
+// a fresh iterator every time the sequence is walked, so walking a range of
+// any length runs in constant memory.
+class Sequence{
+public:
+    virtual ~Sequence() = default;
+    virtual std::unique_ptr<Iterator> iterate() const = 0;
+    virtual size_t size() const;        // counts by walking unless overridden
+    virtual std::string repr() const = 0;
+
+    static std::shared_ptr<const Sequence> range(long start, long stop, long step);
+    static std::shared_ptr<const Sequence> linspace(double start, double stop, size_t count);
+    static std::shared_ptr<const Sequence> lines(const std::string& filename);
+};
+
+// -*-
+// Open addressing hash table in the Swiss-table layout: one control byte per
+// slot holds 7 bits of the key's hash and slots are probed sixteen at a time.
+// Keys are compared with Object::operator== and hashed with Object::hash().
+class HashMap{
+public:
+    HashMap();
+
+    size_t size() const { return this->m_size; }
+    const Object* find(const Object& key) const;
+    void insert(const Object& key, const Object& value);
+    bool erase(const Object& key);
+    std::vector<Object> keys() const;
+    std::vector<Object> values() const;
+    std::vector<Object> items() const;      // ((key value) ...)
+    size_t memory_size(std::unordered_set<const void*>& seen) const;
+
+private:
+    std::vector<std::int8_t> m_ctrl;        // Empty, Deleted or 7-bit hash
+    std::vector<size_t> m_hashes;
+    std::vector<Object> m_keys;
+    std::vector<Object> m_values;
+    size_t m_size;
+    size_t m_tombstones;
+
+    size_t locate(const Object& key, size_t hash) const;
+    void rehash(size_t capacity);
+};
+
+// -*-
+// Immutable vector: a 32-way radix trie plus a tail buffer of up to 32
+// elements. push_back, set and pop_back copy a single root-to-leaf path,
+// O(log32 n), and share every other node with the original.
+class PersistentVector{
+public:
+    PersistentVector();
+
+    size_t size() const { return this->m_size; }
+    const Object& at(size_t index) const;
+    PersistentVector push_back(const Object& value) const;
+    PersistentVector set(size_t index, const Object& value) const;
+    PersistentVector pop_back() const;
+    std::vector<Object> to_list() const;
+    size_t memory_size(std::unordered_set<const void*>& seen) const;
+
+private:
+    struct Node;
+    typedef std::shared_ptr<const Node> NodePtr;
+    typedef std::shared_ptr<const std::vector<Object>> Leaf;
+
+    size_t m_size;
+    unsigned m_shift;               // depth of the trie times 5
+    NodePtr m_root;
+    Leaf m_tail;
+
+    size_t tail_offset() const;
+    const std::vector<Object>& leaf(size_t index) const;
+    NodePtr push_tail(unsigned level, const NodePtr& parent, const NodePtr& tail) const;
+    NodePtr pop_tail(unsigned level, const NodePtr& node) const;
+    static NodePtr new_path(unsigned level, const NodePtr& node);
+    static NodePtr assoc(unsigned level, const NodePtr& node, size_t index, const Object& value);
+    static size_t node_size(const NodePtr& node, std::unordered_set<const void*>& seen);
+};
+
+// -*-
+// Immutable hash map as a hash array mapped trie: each level consumes 5 bits
+// of Object::hash() and stores only its occupied slots behind a bitmap.
+// Keys whose full hashes collide share a collision node at the bottom.
+class PersistentMap{
+public:
+    PersistentMap();
+
+    size_t size() const { return this->m_size; }
+    const Object* find(const Object& key) const;
+    PersistentMap set(const Object& key, const Object& value) const;
+    PersistentMap erase(const Object& key) const;
+    std::vector<Object> keys() const;
+    std::vector<Object> values() const;
+    std::vector<Object> items() const;      // ((key value) ...)
+    size_t memory_size(std::unordered_set<const void*>& seen) const;
+
+private:
+    struct Node;
+    typedef std::shared_ptr<const Node> NodePtr;
+
+    NodePtr m_root;
+    size_t m_size;
+
+    static NodePtr assoc(
+        const NodePtr& node, unsigned shift, size_t hash,
+        const Object& key, const Object& value, bool& added);
+    static NodePtr dissoc(
+        const NodePtr& node, unsigned shift, size_t hash, const Object& key, bool& removed);
+    static void collect(const NodePtr& node, std::vector<Object>& out, int what);
+    static size_t node_size(const NodePtr& node, std::unordered_set<const void*>& seen);
+};
+
+// -*-
+// Results of a memoized function keyed on its argument list. Keys are hashed
+// structurally with Object::hash() and compared element by element; once the
+// cache is full the least recently used entry is evicted.
+class MemoCache{
+public:
+    explicit MemoCache(size_t capacity);
+
+    size_t size() const { return this->m_entries.size(); }
+    size_t capacity() const { return this->m_capacity; }
+    size_t hits() const { return this->m_hits; }
+    size_t misses() const { return this->m_misses; }
+    // counts a hit or a miss; a hit becomes the most recently used entry
+    const Object* find(const std::vector<Object>& args);
+    void insert(const std::vector<Object>& args, const Object& result);
+    void clear();
+    size_t memory_size(std::unordered_set<const void*>& seen) const;
+
+private:
+    struct Entry{
+        size_t hash;
+        std::vector<Object> args;
+        Object result;
+    };
+    typedef std::list<Entry>::iterator Position;
+
+    size_t m_capacity;
+    size_t m_hits;
+    size_t m_misses;
+    std::list<Entry> m_entries;                         // most recent first
+    std::unordered_multimap<size_t, Position> m_index;  // hash -> entry
+
+    Position locate(const std::vector<Object>& args, size_t hash);
+};
+
+// -*-
+// Sorting behind sort and sort-by; objects are ordered by Object::compare.
+// Large inputs are cut into runs that are introsorted on separate threads and
+// then merged pairwise, each level of merges also running in parallel.
+namespace sorting{
+void sort(std::vector<double>& data);          // NaN last
+void sort(std::vector<long>& data);
+void sort(std::vector<Object>& items);
+// stable; keys[i] is the sort key of items[i]
+void sort_by(std::vector<Object>& items, const std::vector<Object>& keys);
+}
+
 // -*----------*-
 // -*- Parser -*-
 // -*----------*-
@@ -271,9 +921,12 @@ private:
     std::string::const_iterator m_begin;
     std::string::const_iterator m_end;
     std::string::iterator m_iter;
+    // position of m_mark, advanced lazily by position()
+    std::string::const_iterator m_mark;
+    Span m_span;
 
 public:
-    Parser(const std::string& source);
+    Parser(const std::string& source, const std::string& filename="<input>");
     ~Parser() = default;
 
     // -*-
@@ -282,17 +935,49 @@ public:
 private:
     void skip_whitespace();
     void skip_line();
+    Span position();
     bool is_valid_atom_char();
     Object next_token();
     void skip_if(bool predicate);
     Object read_unit();
     Object read_quote();
+    Object read_quasiquote();
     Object read_list();
     Object read_number();
     Object read_string();
     Object read_atom();
 };
 
+// -*-
+// Bounds on one execution; zero leaves a bound off. Fuel counts
+// evaluations, the deadline is wall-clock time from the start, and memory
+// is the growth of the process's resident set over that of the start.
+// Running out raises a RuntimeError. From then on every evaluation raises
+// it again, so a script cannot catch its way past the limit, but the
+// caller of Runtime::execute() can and the interpreter stays usable.
+struct Limits{
+    std::uint64_t fuel = 0;
+    double seconds = 0;
+    size_t memory = 0;              // bytes
+};
+
+// -*-
+// Puts limits in force on this thread for its lifetime. Nested budgets
+// only ever tighten the enclosing one, and evaluations made under an inner
+// budget are charged to the outer one too.
+class Budget{
+public:
+    explicit Budget(const Limits& limits);
+    ~Budget();
+    Budget(const Budget&) = delete;
+    Budget& operator=(const Budget&) = delete;
+
+private:
+    std::uint64_t m_fuel_end;
+    std::uint64_t m_deadline;
+    size_t m_memory_end;
+};
+
 // -*-
 
 class Runtime{
@@ -308,12 +993,23 @@ public:
     static std::string read_file(const std::string& filename);
     // +run(std::string, Env<Object>&) -> Object
     //static Object execute(Env& env);
-    static Object execute(std::string source, Env& env);
+    static Object execute(std::string source, Env& env, const std::string& filename="<input>");
+    // runs under a Budget of these limits instead of Runtime::limits
+    static Object execute(std::string source, Env& env, const Limits& limits, const std::string& filename="<input>");
     //static Object execute(std::string filename);
     static void repl(Env& env);
     static Env builtins;
+    // nested lambda calls allowed before a RuntimeError; the native stack
+    // is checked as well, whichever runs out first
+    static size_t recursion_limit;
+    // limits of every execution; all off unless set, e.g. from the command line
+    static Limits limits;
 };
 
+// -*-
+// The builtin functions, bound by name; Runtime::builtins is set from it.
+Env swzlisp_init();
+
 
 // -*-------------------------------------------------------------------*-
 }//-*- end::namespace::swzlisp                                         -*-
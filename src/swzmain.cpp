@@ -0,0 +1,164 @@
+#include "swzlisp.hpp"
+#include<algorithm>
+#include<csignal>
+#include<pthread.h>
+
+// -*-------------------------------------------------------------------*-
+// -*- namespace::swzlisp                                              -*-
+// -*-------------------------------------------------------------------*-
+namespace swzlisp{
+// -*-
+// ./prog
+// ./prog -h
+// ./prog -i
+// ./prog -f filename
+// ./prog -c sexpr
+// ./prog --profile out.folded -f filename
+// ./prog --trace out.json -f filename
+// ./prog --fuel 1000000 --timeout 2 --memory 512 -f filename
+
+
+static std::string progname;
+
+static void usage(){
+    std::string help = progname + " [--profile out] [--trace out] [--fuel n] [--timeout s] [--memory mb]\n";
+    help += std::string(progname.size(), ' ') + " [-h]|[-i]|[-c sexpr]|[-f filename]\n";
+    std::cout << help << std::endl;
+    std::cout << "Options:\n";
+    std::cout << "     -h              Print this message\n";
+    std::cout << "     -i              Enter interactive mode\n";
+    std::cout << "     -c sexpr        Run 'sexpr'\n";
+    std::cout << "     -f script       Run 'scipt' in batch mode\n";
+    std::cout << "     --profile out   Sample the run and write collapsed stacks to 'out'\n";
+    std::cout << "     --trace out     Write a Chrome trace (JSON) of the run to 'out'\n";
+    std::cout << "     --fuel n        Stop any execution after 'n' evaluations\n";
+    std::cout << "     --timeout s     Stop any execution running longer than 's' seconds\n";
+    std::cout << "     --memory mb     Stop any execution growing memory by over 'mb' MiB" << std::endl;
+}
+
+// -*--------------------------------------------------------------------*-
+}//-*- end::namespace::swzlisp                                          -*-
+// -*--------------------------------------------------------------------*-
+
+static void sighandler(int sig){
+    if(sig==SIGINT || sig==SIGTERM){
+        std::exit(EXIT_SUCCESS);
+    }
+}
+
+// -*-------------------------*-
+// -*- M A I N   D R I V E R -*-
+// -*-------------------------*-
+// Deep recursion needs far more than the default 8 MiB of stack, so the
+// interpreter runs on a thread with a larger one. Only the pages actually
+// touched are committed; the evaluator reports exhaustion as a RuntimeError.
+static const size_t EVAL_STACK_SIZE = size_t(256) << 20;
+
+struct Program{
+    int argc;
+    char **argv;
+};
+
+// Written at exit as well, so that a script calling (exit) keeps its trace.
+static std::string trace_file;
+
+static void flush_trace(){
+    if(trace_file.empty()){
+        return;
+    }
+    swzlisp::Tracer::stop();
+    std::ofstream out(trace_file);
+    swzlisp::Tracer::write_json(out);
+    trace_file.clear();
+}
+
+static void* run(void* data){
+    int argc = static_cast<Program*>(data)->argc;
+    char **argv = static_cast<Program*>(data)->argv;
+    swzlisp::progname = argv[0];
+    // --profile out.folded ... samples the whole run,
+    // --trace out.json ... records its timeline, and
+    // --fuel n, --timeout seconds, --memory megabytes bound each execution
+    std::string profile;
+    auto& limits = swzlisp::Runtime::limits;
+    while(argc >= 3){
+        std::string option(argv[1]);
+        const char* value = argv[2];
+        if(option == "--profile"){
+            profile = value;
+        }else if(option == "--trace"){
+            trace_file = value;
+        }else if(option == "--fuel"){
+            limits.fuel = std::strtoull(value, nullptr, 10);
+        }else if(option == "--timeout"){
+            limits.seconds = std::max(0.0, std::strtod(value, nullptr));
+        }else if(option == "--memory"){
+            limits.memory = static_cast<size_t>(std::max(0.0, std::strtod(value, nullptr)) * (1 << 20));
+        }else{
+            break;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    swzlisp::Runtime::builtins = swzlisp::swzlisp_init();
+    swzlisp::Env workspace(swzlisp::Runtime::builtins);
+    std::vector<swzlisp::Object> args;
+    for(int i=0; i < argc; i++){
+        args.emplace_back(swzlisp::Object::create_string(std::string(argv[i])));
+    }
+    swzlisp::Object self(args);
+    workspace.put(":argv", self);
+
+    try{
+        if(!profile.empty()){
+            swzlisp::Profiler::start();
+        }
+        if(!trace_file.empty()){
+            std::atexit(flush_trace);
+            swzlisp::Tracer::start();
+        }
+        if(argc == 1 || (argc==2 && std::string(argv[1]) == "-i")){
+            swzlisp::Runtime::repl(workspace);
+        }else if(argc == 2 && std::string(argv[1])=="-h"){
+            swzlisp::usage();
+        }else if(argc==3 && std::string(argv[1])=="-c"){
+            std::string sexpr(argv[2]);
+            swzlisp::Runtime::execute(sexpr, workspace);
+        }else if(argc==3 && std::string(argv[1])=="-f"){
+            std::string filename(argv[2]);
+            std::string source = swzlisp::Runtime::read_file(filename);
+            swzlisp::Runtime::execute(source, workspace, filename);
+        }
+    }catch(swzlisp::Error& err){
+        std::cerr << err.describe() << std::endl;
+    }catch(std::exception& err){
+        std::cerr << err.what() << std::endl;
+    }
+    if(!profile.empty()){
+        swzlisp::Profiler::stop();
+        std::ofstream out(profile);
+        swzlisp::Profiler::write_folded(out);
+    }
+    flush_trace();
+
+    return nullptr;
+}
+
+int main(int argc, char **argv){
+    std::signal(SIGINT, sighandler);
+    std::signal(SIGTERM, sighandler);    
+    Program program{argc, argv};
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, EVAL_STACK_SIZE);
+    if(pthread_create(&thread, &attr, run, &program) == 0){
+        pthread_join(thread, nullptr);
+    }else{
+        run(&program);
+    }
+    pthread_attr_destroy(&attr);
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
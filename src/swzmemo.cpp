@@ -0,0 +1,123 @@
+#include "swzlisp.hpp"
+#include<algorithm>
+
+// -*-------------------------------------------------------------------*-
+// -*- namespace::swzlisp                                              -*-
+// -*-------------------------------------------------------------------*-
+namespace swzlisp{
+// -*-------------------------------------------------------------------*-
+// -*- MemoCache                                                       -*-
+// -*-------------------------------------------------------------------*-
+namespace{
+// -*-
+// Keys match only when their types do as well as their values, down through
+// lists: operator== takes 1 for 1.0, but (half 1) and (half 1.0) differ.
+bool same_key(const Object& x, const Object& y){
+    if(x.type() != y.type()){
+        return false;
+    }
+    if(x.type() == Type::List){
+        size_t n = x.list_size();
+        if(n != y.list_size()){
+            return false;
+        }
+        for(size_t i=0; i < n; i++){
+            if(!same_key(x.list_at(i), y.list_at(i))){
+                return false;
+            }
+        }
+        return true;
+    }
+    return x == y;
+}
+
+// -*-
+size_t key_hash(const std::vector<Object>& args){
+    size_t result = Object::hash(args);
+    for(const auto& arg: args){
+        result = result*31 + static_cast<size_t>(arg.type());
+    }
+    return result;
+}
+}
+
+MemoCache::MemoCache(size_t capacity)
+: m_capacity{capacity}, m_hits{0}, m_misses{0}{}
+
+// -*-
+MemoCache::Position MemoCache::locate(const std::vector<Object>& args, size_t hash){
+    auto range = this->m_index.equal_range(hash);
+    for(auto iter=range.first; iter != range.second; ++iter){
+        const auto& key = iter->second->args;
+        if(key.size()==args.size() && std::equal(key.begin(), key.end(), args.begin(), same_key)){
+            return iter->second;
+        }
+    }
+    return this->m_entries.end();
+}
+
+// -*-
+const Object* MemoCache::find(const std::vector<Object>& args){
+    auto pos = this->locate(args, key_hash(args));
+    if(pos == this->m_entries.end()){
+        this->m_misses++;
+        return nullptr;
+    }
+    this->m_hits++;
+    this->m_entries.splice(this->m_entries.begin(), this->m_entries, pos);
+    return &pos->result;
+}
+
+// -*-
+void MemoCache::insert(const std::vector<Object>& args, const Object& result){
+    if(this->m_capacity == 0){
+        return;
+    }
+    size_t hash = key_hash(args);
+    auto pos = this->locate(args, hash);
+    if(pos != this->m_entries.end()){
+        // a recursive call computed the same arguments first
+        pos->result = result;
+        this->m_entries.splice(this->m_entries.begin(), this->m_entries, pos);
+        return;
+    }
+    if(this->m_entries.size() == this->m_capacity){
+        auto last = std::prev(this->m_entries.end());
+        auto range = this->m_index.equal_range(last->hash);
+        for(auto iter=range.first; iter != range.second; ++iter){
+            if(iter->second == last){
+                this->m_index.erase(iter);
+                break;
+            }
+        }
+        this->m_entries.pop_back();
+    }
+    this->m_entries.push_front(Entry{hash, args, result});
+    this->m_index.emplace(hash, this->m_entries.begin());
+}
+
+// -*-
+void MemoCache::clear(){
+    this->m_entries.clear();
+    this->m_index.clear();
+    this->m_hits = 0;
+    this->m_misses = 0;
+}
+
+// -*-
+// Each entry is a list node; the index adds a node per entry and its buckets.
+size_t MemoCache::memory_size(std::unordered_set<const void*>& seen) const{
+    size_t result = sizeof(MemoCache);
+    for(const auto& entry: this->m_entries){
+        result += 2*sizeof(void*) + sizeof(Entry);
+        result += Object::memory_size(entry.args, seen);
+        result += entry.result.memory_size(seen) - sizeof(Object);
+    }
+    result += this->m_index.size()*(sizeof(void*) + sizeof(size_t) + sizeof(Position));
+    result += this->m_index.bucket_count()*sizeof(void*);
+    return result;
+}
+
+// -*-------------------------------------------------------------------*-
+}//-*- end::namespace::swzlisp                                         -*-
+// -*-------------------------------------------------------------------*-
@@ -7,10 +7,30 @@
 // -*------------------------------------------------------------------*-
 namespace swzlisp{
 // -*-
-Parser::Parser(const std::string& source): m_source{source}{
+Parser::Parser(const std::string& source, const std::string& filename): m_source{source}{
     this->m_begin = this->m_source.cbegin();
     this->m_end = this->m_source.cend();
     this->m_iter = this->m_source.begin();
+    this->m_mark = this->m_begin;
+    this->m_span.line = 1;
+    this->m_span.column = 1;
+    this->m_span.file = Span::intern(filename);
+}
+
+// -*-
+// Span of the current character. Tokens are read left to right, so the
+// mark only ever moves forward and the whole source is scanned once.
+Span Parser::position(){
+    std::string::const_iterator iter = this->m_iter;
+    for(; this->m_mark != iter; ++this->m_mark){
+        if(*this->m_mark == '\n'){
+            this->m_span.line++;
+            this->m_span.column = 1;
+        }else if(this->m_span.column < std::numeric_limits<std::uint16_t>::max()){
+            this->m_span.column++;
+        }
+    }
+    return this->m_span;
 }
 
 // -*-
@@ -25,7 +45,8 @@ bool Parser::is_valid_atom_char(){
     bool result = (
         (std::isalpha(*this->m_iter) || std::ispunct(*this->m_iter)) &&
         *this->m_iter != '(' && *this->m_iter != ')' &&
-        *this->m_iter != '"' && *this->m_iter != '\''
+        *this->m_iter != '"' && *this->m_iter != '\'' &&
+        *this->m_iter != '`' && *this->m_iter != ','
     );
 
     return result;
@@ -43,7 +64,7 @@ void Parser::replace(std::string& source, std::string old, std::string neo){
 
 // -*-
 void Parser::skip_line(){
-    while(*this->m_iter !='\n'){ this->m_iter++; }
+    while(this->m_iter != this->m_end && *this->m_iter !='\n'){ this->m_iter++; }
 }
 
 // -*-
@@ -73,6 +94,26 @@ Object Parser::read_quote(){
     return result;
 }
 
+// -*-
+// `x -> (quasiquote x), ,x -> (unquote x), ,@x -> (unquote-splicing x)
+Object Parser::read_quasiquote(){
+    std::string name;
+    if(*this->m_iter=='`'){
+        name = "quasiquote";
+    }else if(*this->m_iter==',' && (this->m_iter+1) != this->m_end && *(this->m_iter+1)=='@'){
+        name = "unquote-splicing";
+        this->m_iter++;
+    }else if(*this->m_iter==','){
+        name = "unquote";
+    }else{
+        throw Error();
+    }
+    this->m_iter++;
+    std::vector<Object> form{Object::create_atom(name)};
+    form.push_back(this->next_token());
+    return Object(form);
+}
+
 // -*-
 Object Parser::read_list(){
     std::string::iterator ptr = this->m_iter;
@@ -85,6 +126,9 @@ Object Parser::read_list(){
     // () result int Type::Unit
     Object result = Object(std::vector<Object>());
     while(*this->m_iter !=')'){
+        if(this->m_iter == this->m_end){
+            throw Error(ErrorKind::SyntaxError, "unbalanced parentheses");
+        }
         result.push(this->next_token());
     }
     this->skip_whitespace();
@@ -120,12 +164,13 @@ Object Parser::read_number(){
         long val{};
         try{
             val = std::stol(number);
+            result = Object(val);
         }catch(std::invalid_argument& err){
             throw Error(Env(), err.what());
         }catch(std::out_of_range& err){
-            throw Error(Env(), err.what());
+            // too wide for a fixnum
+            result = Object::create_integer(Bignum::parse(number));
         }
-        result = Object(val);
     }
     this->m_iter = ptr;
 
@@ -142,7 +187,7 @@ Object Parser::read_string(){
         if(*ptr == '\\'){ ++ptr; }
     }
     Object result;
-    std::string data = std::string(this->m_iter, ptr);
+    std::string data = std::string(this->m_iter+1, ptr);
     ++ptr;
     this->m_iter = ptr;
     this->skip_whitespace();
@@ -164,8 +209,12 @@ Object Parser::read_string(){
 
 // -*-
 Object Parser::read_atom(){
+    Span span = this->position();
     std::string::iterator ptr = this->m_iter;
-    while(this->is_valid_atom_char()){
+    // digits may follow the leading character, e.g. 'f64vec'
+    while(this->is_valid_atom_char() || (
+        this->m_iter != ptr && this->m_iter != this->m_end &&
+        std::isdigit(*this->m_iter))){
         if(this->m_iter == this->m_end){
             throw Error(Env(), ErrorKind::SyntaxError);
         }
@@ -176,23 +225,17 @@ Object Parser::read_atom(){
     std::string data = std::string(ptr, this->m_iter);
     this->skip_whitespace();
     result = Object::create_atom(data);
+    result.locate(span);
     return result;
 }
 
 // -*-
 Object Parser::next_token(){
     this->skip_whitespace();
-    if(*this->m_iter == ';'){
-        bool predicate = (*this->m_iter==';');
-        this->skip_if(predicate);
+    // a comment runs to the end of its line; several may follow each other
+    while(this->m_iter != this->m_end && *this->m_iter == ';'){
         this->skip_line();
         this->skip_whitespace();
-        std::string::iterator ptr = this->m_iter;
-        std::string::iterator end = this->m_source.end()-1;
-        auto data = std::string(ptr, end);
-        if(data == ""){
-            return Object();
-        }
     }
 
     Object result;
@@ -200,6 +243,8 @@ Object Parser::next_token(){
         return Object();
     }else if(*this->m_iter=='\''){
         result = this->read_quote();
+    }else if(*this->m_iter=='`' || *this->m_iter==','){
+        result = this->read_quasiquote();
     }else if(*this->m_iter=='('){
         // try{
         //     result = this->read_unit();
@@ -225,8 +270,13 @@ Object Parser::next_token(){
 // -*-
 std::vector<Object> Parser::parse(){
     std::vector<Object> result{};
-    while(this->m_iter != this->m_end){
-        result.push_back(this->next_token());
+    try{
+        while(this->m_iter != this->m_end){
+            result.push_back(this->next_token());
+        }
+    }catch(Error& err){
+        err.locate(this->position());
+        throw;
     }
 
     if(this->m_iter != this->m_end){
@@ -0,0 +1,476 @@
+#include "swzlisp.hpp"
+
+// -*-------------------------------------------------------------------*-
+// -*- namespace::swzlisp                                              -*-
+// -*-------------------------------------------------------------------*-
+namespace swzlisp{
+namespace{
+constexpr unsigned BITS = 5;
+constexpr size_t WIDTH = size_t(1) << BITS;
+constexpr size_t MASK = WIDTH - 1;
+}
+
+// -*-------------------------------------------------------------------*-
+// -*- PersistentVector                                                -*-
+// -*-------------------------------------------------------------------*-
+// Branch nodes fill `children`, leaves fill `values`. Every leaf of the trie
+// is full; the last (partial) chunk lives in the tail so appends rarely touch
+// the trie at all.
+struct PersistentVector::Node{
+    std::vector<NodePtr> children;
+    std::vector<Object> values;
+};
+
+// -*-
+PersistentVector::PersistentVector()
+: m_size{0}, m_shift{BITS}, m_root{std::make_shared<const Node>()},
+  m_tail{std::make_shared<const std::vector<Object>>()}{}
+
+// -*-
+size_t PersistentVector::tail_offset() const{
+    return this->m_size < WIDTH ? 0 : ((this->m_size - 1) >> BITS) << BITS;
+}
+
+// -*-
+const std::vector<Object>& PersistentVector::leaf(size_t index) const{
+    if(index >= this->tail_offset()){
+        return *this->m_tail;
+    }
+    const Node* node = this->m_root.get();
+    for(unsigned level=this->m_shift; level > 0; level -= BITS){
+        node = node->children[(index >> level) & MASK].get();
+    }
+    return node->values;
+}
+
+// -*-
+const Object& PersistentVector::at(size_t index) const{
+    if(index >= this->m_size){
+        throw Error(Env(), "index out of range");
+    }
+    return this->leaf(index)[index & MASK];
+}
+
+// -*-
+PersistentVector::NodePtr PersistentVector::new_path(unsigned level, const NodePtr& node){
+    if(level == 0){
+        return node;
+    }
+    auto result = std::make_shared<Node>();
+    result->children.push_back(new_path(level - BITS, node));
+    return result;
+}
+
+// -*-
+PersistentVector::NodePtr PersistentVector::push_tail(
+    unsigned level, const NodePtr& parent, const NodePtr& tail) const
+{
+    size_t sub = ((this->m_size - 1) >> level) & MASK;
+    auto result = std::make_shared<Node>(*parent);
+    NodePtr child;
+    if(level == BITS){
+        child = tail;
+    }else if(sub < parent->children.size()){
+        child = this->push_tail(level - BITS, parent->children[sub], tail);
+    }else{
+        child = new_path(level - BITS, tail);
+    }
+    if(sub < result->children.size()){
+        result->children[sub] = child;
+    }else{
+        result->children.push_back(child);
+    }
+    return result;
+}
+
+// -*-
+PersistentVector PersistentVector::push_back(const Object& value) const{
+    PersistentVector result(*this);
+    if(this->m_size - this->tail_offset() < WIDTH){
+        auto tail = std::make_shared<std::vector<Object>>(*this->m_tail);
+        tail->push_back(value);
+        result.m_tail = tail;
+        result.m_size++;
+        return result;
+    }
+
+    // the tail is full: move it into the trie and start a new one
+    auto full = std::make_shared<Node>();
+    full->values = *this->m_tail;
+    if((this->m_size >> BITS) > (size_t(1) << this->m_shift)){
+        auto root = std::make_shared<Node>();
+        root->children.push_back(this->m_root);
+        root->children.push_back(new_path(this->m_shift, full));
+        result.m_root = root;
+        result.m_shift += BITS;
+    }else{
+        result.m_root = this->push_tail(this->m_shift, this->m_root, full);
+    }
+    result.m_tail = std::make_shared<const std::vector<Object>>(1, value);
+    result.m_size++;
+    return result;
+}
+
+// -*-
+PersistentVector::NodePtr PersistentVector::assoc(
+    unsigned level, const NodePtr& node, size_t index, const Object& value)
+{
+    auto result = std::make_shared<Node>(*node);
+    if(level == 0){
+        result->values[index & MASK] = value;
+    }else{
+        size_t sub = (index >> level) & MASK;
+        result->children[sub] = assoc(level - BITS, node->children[sub], index, value);
+    }
+    return result;
+}
+
+// -*-
+PersistentVector PersistentVector::set(size_t index, const Object& value) const{
+    if(index >= this->m_size){
+        throw Error(Env(), "index out of range");
+    }
+    PersistentVector result(*this);
+    if(index >= this->tail_offset()){
+        auto tail = std::make_shared<std::vector<Object>>(*this->m_tail);
+        (*tail)[index & MASK] = value;
+        result.m_tail = tail;
+    }else{
+        result.m_root = assoc(this->m_shift, this->m_root, index, value);
+    }
+    return result;
+}
+
+// -*-
+// Drops the rightmost leaf; returns null once a subtree becomes empty.
+PersistentVector::NodePtr PersistentVector::pop_tail(unsigned level, const NodePtr& node) const{
+    size_t sub = ((this->m_size - 2) >> level) & MASK;
+    if(level > BITS){
+        auto child = this->pop_tail(level - BITS, node->children[sub]);
+        if(child == nullptr && sub == 0){
+            return nullptr;
+        }
+        auto result = std::make_shared<Node>(*node);
+        if(child == nullptr){
+            result->children.pop_back();
+        }else{
+            result->children[sub] = child;
+        }
+        return result;
+    }
+    if(sub == 0){
+        return nullptr;
+    }
+    auto result = std::make_shared<Node>(*node);
+    result->children.pop_back();
+    return result;
+}
+
+// -*-
+PersistentVector PersistentVector::pop_back() const{
+    if(this->m_size == 0){
+        throw Error(Env(), "index out of range");
+    }
+    if(this->m_size == 1){
+        return PersistentVector();
+    }
+    PersistentVector result(*this);
+    if(this->m_size - this->tail_offset() > 1){
+        auto tail = std::make_shared<std::vector<Object>>(*this->m_tail);
+        tail->pop_back();
+        result.m_tail = tail;
+        result.m_size--;
+        return result;
+    }
+
+    // the tail empties: the last trie leaf becomes the new tail
+    result.m_tail = std::make_shared<const std::vector<Object>>(this->leaf(this->m_size - 2));
+    auto root = this->pop_tail(this->m_shift, this->m_root);
+    if(root == nullptr){
+        root = std::make_shared<const Node>();
+    }
+    if(this->m_shift > BITS && root->children.size() == 1){
+        root = root->children[0];
+        result.m_shift -= BITS;
+    }
+    result.m_root = root;
+    result.m_size--;
+    return result;
+}
+
+// -*-
+std::vector<Object> PersistentVector::to_list() const{
+    std::vector<Object> result;
+    result.reserve(this->m_size);
+    for(size_t i=0; i < this->m_size; i += WIDTH){
+        auto& values = this->leaf(i);
+        result.insert(result.end(), values.begin(), values.end());
+    }
+    return result;
+}
+
+// -*-
+// Nodes and leaves shared with other versions are counted only once.
+size_t PersistentVector::memory_size(std::unordered_set<const void*>& seen) const{
+    size_t result = sizeof(PersistentVector) + node_size(this->m_root, seen);
+    if(this->m_tail && seen.insert(this->m_tail.get()).second){
+        result += sizeof(*this->m_tail) + Object::memory_size(*this->m_tail, seen);
+    }
+    return result;
+}
+
+// -*-
+size_t PersistentVector::node_size(const NodePtr& node, std::unordered_set<const void*>& seen){
+    if(node == nullptr || !seen.insert(node.get()).second){
+        return 0;
+    }
+    size_t result = sizeof(Node) + node->children.capacity()*sizeof(NodePtr);
+    result += Object::memory_size(node->values, seen);
+    for(const auto& child: node->children){
+        result += node_size(child, seen);
+    }
+    return result;
+}
+
+// -*-------------------------------------------------------------------*-
+// -*- PersistentMap                                                   -*-
+// -*-------------------------------------------------------------------*-
+// An entry is either a key/value pair or, when `child` is set, a sub-trie.
+// Bitmap nodes keep their entries in slot order; a collision node (reached
+// once every hash bit has been consumed) keeps a plain list of pairs.
+namespace{
+constexpr unsigned HASH_BITS = 8 * sizeof(size_t);
+
+inline unsigned popcount(std::uint32_t bits){
+    return static_cast<unsigned>(__builtin_popcount(bits));
+}
+}
+
+struct PersistentMap::Node{
+    struct Entry{
+        size_t hash;
+        Object key;
+        Object value;
+        NodePtr child;
+    };
+    std::uint32_t bitmap = 0;
+    bool collision = false;
+    std::vector<Entry> entries;
+};
+
+// -*-
+PersistentMap::PersistentMap(): m_root{nullptr}, m_size{0}{}
+
+// -*-
+const Object* PersistentMap::find(const Object& key) const{
+    const size_t hash = key.hash();
+    const Node* node = this->m_root.get();
+    unsigned shift = 0;
+    while(node != nullptr){
+        if(node->collision){
+            for(auto& entry: node->entries){
+                if(entry.key == key){
+                    return &entry.value;
+                }
+            }
+            return nullptr;
+        }
+        std::uint32_t bit = std::uint32_t(1) << ((hash >> shift) & MASK);
+        if(!(node->bitmap & bit)){
+            return nullptr;
+        }
+        auto& entry = node->entries[popcount(node->bitmap & (bit - 1))];
+        if(entry.child == nullptr){
+            return entry.hash == hash && entry.key == key ? &entry.value : nullptr;
+        }
+        node = entry.child.get();
+        shift += BITS;
+    }
+    return nullptr;
+}
+
+// -*-
+PersistentMap::NodePtr PersistentMap::assoc(
+    const NodePtr& node, unsigned shift, size_t hash,
+    const Object& key, const Object& value, bool& added)
+{
+    if(shift >= HASH_BITS){
+        auto result = node ? std::make_shared<Node>(*node) : std::make_shared<Node>();
+        result->collision = true;
+        for(auto& entry: result->entries){
+            if(entry.key == key){
+                entry.value = value;
+                return result;
+            }
+        }
+        result->entries.push_back({hash, key, value, nullptr});
+        added = true;
+        return result;
+    }
+
+    auto result = node ? std::make_shared<Node>(*node) : std::make_shared<Node>();
+    std::uint32_t bit = std::uint32_t(1) << ((hash >> shift) & MASK);
+    size_t pos = popcount(result->bitmap & (bit - 1));
+    if(!(result->bitmap & bit)){
+        result->bitmap |= bit;
+        result->entries.insert(result->entries.begin() + pos, {hash, key, value, nullptr});
+        added = true;
+        return result;
+    }
+
+    auto& entry = result->entries[pos];
+    if(entry.child != nullptr){
+        entry.child = assoc(entry.child, shift + BITS, hash, key, value, added);
+    }else if(entry.hash == hash && entry.key == key){
+        entry.value = value;
+    }else{
+        // two keys share this slot: push both one level down
+        bool ignored = false;
+        auto child = assoc(nullptr, shift + BITS, entry.hash, entry.key, entry.value, ignored);
+        child = assoc(child, shift + BITS, hash, key, value, added);
+        entry = {0, Object(), Object(), child};
+    }
+    return result;
+}
+
+// -*-
+PersistentMap PersistentMap::set(const Object& key, const Object& value) const{
+    bool added = false;
+    PersistentMap result;
+    result.m_root = assoc(this->m_root, 0, key.hash(), key, value, added);
+    result.m_size = this->m_size + (added ? 1 : 0);
+    return result;
+}
+
+// -*-
+PersistentMap::NodePtr PersistentMap::dissoc(
+    const NodePtr& node, unsigned shift, size_t hash, const Object& key, bool& removed)
+{
+    if(node == nullptr){
+        return node;
+    }
+    if(node->collision){
+        for(size_t i=0; i < node->entries.size(); i++){
+            if(node->entries[i].key == key){
+                removed = true;
+                if(node->entries.size() == 1){
+                    return nullptr;
+                }
+                auto result = std::make_shared<Node>(*node);
+                result->entries.erase(result->entries.begin() + i);
+                return result;
+            }
+        }
+        return node;
+    }
+
+    std::uint32_t bit = std::uint32_t(1) << ((hash >> shift) & MASK);
+    if(!(node->bitmap & bit)){
+        return node;
+    }
+    size_t pos = popcount(node->bitmap & (bit - 1));
+    auto& entry = node->entries[pos];
+    NodePtr child = nullptr;
+    if(entry.child != nullptr){
+        child = dissoc(entry.child, shift + BITS, hash, key, removed);
+        if(!removed){
+            return node;
+        }
+    }else if(entry.hash == hash && entry.key == key){
+        removed = true;
+    }else{
+        return node;
+    }
+
+    auto result = std::make_shared<Node>(*node);
+    if(child != nullptr){
+        // a sub-trie left with a single pair folds back into this level
+        if(!child->collision && child->entries.size() == 1 && child->entries[0].child == nullptr){
+            result->entries[pos] = child->entries[0];
+        }else{
+            result->entries[pos].child = child;
+        }
+        return result;
+    }
+    result->bitmap &= ~bit;
+    result->entries.erase(result->entries.begin() + pos);
+    if(result->entries.empty()){
+        return nullptr;
+    }
+    return result;
+}
+
+// -*-
+PersistentMap PersistentMap::erase(const Object& key) const{
+    bool removed = false;
+    PersistentMap result;
+    result.m_root = dissoc(this->m_root, 0, key.hash(), key, removed);
+    result.m_size = this->m_size - (removed ? 1 : 0);
+    return result;
+}
+
+// -*-
+// what: 0 -> keys, 1 -> values, 2 -> (key value) pairs
+void PersistentMap::collect(const NodePtr& node, std::vector<Object>& out, int what){
+    if(node == nullptr){
+        return;
+    }
+    for(auto& entry: node->entries){
+        if(entry.child != nullptr){
+            collect(entry.child, out, what);
+        }else if(what == 0){
+            out.push_back(entry.key);
+        }else if(what == 1){
+            out.push_back(entry.value);
+        }else{
+            out.push_back(Object(std::vector<Object>{entry.key, entry.value}));
+        }
+    }
+}
+
+// -*-
+std::vector<Object> PersistentMap::keys() const{
+    std::vector<Object> result;
+    result.reserve(this->m_size);
+    collect(this->m_root, result, 0);
+    return result;
+}
+
+// -*-
+std::vector<Object> PersistentMap::values() const{
+    std::vector<Object> result;
+    result.reserve(this->m_size);
+    collect(this->m_root, result, 1);
+    return result;
+}
+
+// -*-
+std::vector<Object> PersistentMap::items() const{
+    std::vector<Object> result;
+    result.reserve(this->m_size);
+    collect(this->m_root, result, 2);
+    return result;
+}
+
+// -*-
+size_t PersistentMap::memory_size(std::unordered_set<const void*>& seen) const{
+    return sizeof(PersistentMap) + node_size(this->m_root, seen);
+}
+
+// -*-
+size_t PersistentMap::node_size(const NodePtr& node, std::unordered_set<const void*>& seen){
+    if(node == nullptr || !seen.insert(node.get()).second){
+        return 0;
+    }
+    size_t result = sizeof(Node) + node->entries.capacity()*sizeof(Node::Entry);
+    for(const auto& entry: node->entries){
+        result += entry.key.memory_size(seen) - sizeof(Object);
+        result += entry.value.memory_size(seen) - sizeof(Object);
+        result += node_size(entry.child, seen);
+    }
+    return result;
+}
+
+// -*-------------------------------------------------------------------*-
+}//-*- end::namespace::swzlisp                                         -*-
+// -*-------------------------------------------------------------------*-
@@ -0,0 +1,558 @@
+#include "swzlisp.hpp"
+#include<unordered_set>
+#include<algorithm>
+#include<iomanip>
+#include<chrono>
+#include<mutex>
+#include<csignal>
+#include<sys/time.h>
+
+// -*-------------------------------------------------------------------*-
+// -*- namespace::swzlisp                                              -*-
+// -*-------------------------------------------------------------------*-
+namespace swzlisp{
+// -*-
+FrameName intern_name(const std::string& name){
+    static std::unordered_set<std::string> names;
+    // elements of an unordered_set keep their address across rehashes
+    return &*names.insert(name).first;
+}
+
+// -*-------------------------------------------------------------------*-
+// -*- CallStack                                                       -*-
+// -*-------------------------------------------------------------------*-
+FrameName CallStack::s_frames[CallStack::CAPACITY];
+volatile size_t CallStack::s_depth = 0;
+
+// -*-------------------------------------------------------------------*-
+// -*- Profiler                                                        -*-
+// -*-------------------------------------------------------------------*-
+// Each sample is stored as its depth followed by that many frames, outer
+// first. The buffer is sized once in start(), so the handler only copies.
+namespace{
+constexpr size_t BUFFER_SLOTS = size_t(1) << 21;
+
+std::vector<FrameName> s_buffer;
+volatile size_t s_used = 0;
+volatile size_t s_samples = 0;
+volatile size_t s_dropped = 0;
+volatile bool s_running = false;
+struct sigaction s_previous;
+
+void on_sample(int){
+    size_t depth = std::min(CallStack::depth(), CallStack::CAPACITY);
+    std::atomic_signal_fence(std::memory_order_acquire);
+    size_t used = s_used;
+    if(depth == 0){
+        return;
+    }
+    if(used + depth + 1 > s_buffer.size()){
+        s_dropped = s_dropped + 1;
+        return;
+    }
+    // the depth slot holds a count, not a name
+    s_buffer[used] = reinterpret_cast<FrameName>(depth);
+    for(size_t i=0; i < depth; i++){
+        s_buffer[used + 1 + i] = CallStack::at(i);
+    }
+    s_used = used + depth + 1;
+    s_samples = s_samples + 1;
+}
+}
+
+// -*-
+void Profiler::start(unsigned hertz){
+    if(s_running){
+        throw Error(ErrorKind::RuntimError, "profiler: already running");
+    }
+    if(hertz == 0 || hertz > MAX_HERTZ){
+        throw Error(ErrorKind::ValueError, "profiler: frequency must be in 1.." + std::to_string(MAX_HERTZ) + " Hz");
+    }
+    s_buffer.assign(BUFFER_SLOTS, nullptr);
+    s_used = 0;
+    s_samples = 0;
+    s_dropped = 0;
+
+    struct sigaction action{};
+    action.sa_handler = on_sample;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &s_previous);
+
+    itimerval timer{};
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = static_cast<long>(1000000 / hertz);
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    s_running = true;
+}
+
+// -*-
+void Profiler::stop(){
+    if(!s_running){
+        return;
+    }
+    itimerval timer{};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sigaction(SIGPROF, &s_previous, nullptr);
+    s_running = false;
+}
+
+// -*-
+bool Profiler::running(){
+    return s_running;
+}
+
+// -*-
+size_t Profiler::samples(){
+    return s_samples;
+}
+
+// -*-
+size_t Profiler::dropped(){
+    return s_dropped;
+}
+
+// -*-
+void Profiler::write_folded(std::ostream& out){
+    std::map<std::string, size_t> stacks;
+    size_t used = s_used;
+    for(size_t pos=0; pos < used; ){
+        size_t depth = reinterpret_cast<size_t>(s_buffer[pos]);
+        std::string key;
+        for(size_t i=0; i < depth; i++){
+            if(i > 0){
+                key += ';';
+            }
+            key += *s_buffer[pos + 1 + i];
+        }
+        stacks[key]++;
+        pos += depth + 1;
+    }
+    for(const auto& [stack, count]: stacks){
+        out << stack << " " << count << "\n";
+    }
+}
+
+// -*-------------------------------------------------------------------*-
+// -*- Stats                                                           -*-
+// -*-------------------------------------------------------------------*-
+// A timer is pushed on entry to each call and popped on exit; a finished
+// call adds its duration to its caller's child time, which is what turns
+// inclusive into exclusive time.
+namespace{
+typedef std::chrono::steady_clock Clock;
+
+struct Counter{
+    std::uint64_t calls = 0;
+    Clock::duration inclusive{0};
+    Clock::duration exclusive{0};
+};
+
+struct Timer{
+    Clock::time_point start;
+    Clock::duration children{0};
+};
+
+std::unordered_map<FrameName, Counter> s_counters;
+std::vector<Timer> s_timers;
+}
+
+bool Stats::s_enabled = false;
+
+// -*-
+void Stats::enable(bool flag){
+    s_enabled = flag;
+}
+
+// -*-
+void Stats::reset(){
+    s_counters.clear();
+}
+
+// -*-
+void Stats::enter(){
+    s_timers.push_back(Timer{Clock::now(), Clock::duration{0}});
+}
+
+// -*-
+void Stats::leave(FrameName name){
+    Timer timer = s_timers.back();
+    s_timers.pop_back();
+    auto elapsed = Clock::now() - timer.start;
+    Counter& counter = s_counters[name];
+    counter.calls++;
+    counter.inclusive += elapsed;
+    counter.exclusive += elapsed - timer.children;
+    if(!s_timers.empty()){
+        s_timers.back().children += elapsed;
+    }
+}
+
+// -*-
+std::vector<Stats::Entry> Stats::entries(){
+    std::vector<Entry> result;
+    result.reserve(s_counters.size());
+    for(const auto& [name, counter]: s_counters){
+        result.push_back(Entry{
+            *name, counter.calls,
+            std::chrono::duration<double>(counter.inclusive).count(),
+            std::chrono::duration<double>(counter.exclusive).count()
+        });
+    }
+    std::sort(result.begin(), result.end(), [](const Entry& x, const Entry& y){
+        return x.exclusive > y.exclusive;
+    });
+    return result;
+}
+
+// -*-
+void Stats::print(std::ostream& out){
+    auto flags = out.flags();
+    auto precision = out.precision();
+    out << "------------------------------------------------------------------\n";
+    out << "          FUNCTION |      CALLS | INCLUSIVE (ms) | EXCLUSIVE (ms)\n";
+    out << "------------------------------------------------------------------\n";
+    for(const auto& entry: Stats::entries()){
+        out << " " << std::setw(17) << entry.name << " |";
+        out << " " << std::setw(10) << entry.calls << " |";
+        out << " " << std::setw(14) << std::fixed << std::setprecision(3) << entry.inclusive*1e3 << " |";
+        out << " " << std::setw(14) << entry.exclusive*1e3 << "\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+    if(!s_enabled){
+        out << "(collection is off; ':stats on' or (runtime-stats-enable) to start)\n";
+    }
+}
+
+// -*-------------------------------------------------------------------*-
+// -*- Accounting                                                      -*-
+// -*-------------------------------------------------------------------*-
+// Events are charged to the innermost frame that was stored; code outside
+// any call, or past CallStack::CAPACITY frames deep, goes to a shared row.
+namespace{
+struct Tally{
+    std::uint64_t counts[Accounting::NEVENTS] = {};
+};
+
+std::unordered_map<FrameName, Tally> s_tallies;
+
+const char* EVENT_NAMES[Accounting::NEVENTS] = {
+    "OBJECT COPIES", "LIST ALLOCS", "STRING ALLOCS", "ENV COPIES"
+};
+}
+
+bool Accounting::s_enabled = false;
+
+// -*-
+void Accounting::enable(bool flag){
+    s_enabled = flag;
+}
+
+// -*-
+void Accounting::reset(){
+    s_tallies.clear();
+}
+
+// -*-
+void Accounting::count(Event event){
+    static const FrameName toplevel = intern_name("<toplevel>");
+    size_t depth = CallStack::depth();
+    FrameName name = (depth == 0 || depth > CallStack::CAPACITY) ? toplevel : CallStack::at(depth - 1);
+    s_tallies[name].counts[event]++;
+}
+
+// -*-
+std::vector<Accounting::Entry> Accounting::entries(){
+    std::vector<Entry> result;
+    result.reserve(s_tallies.size());
+    for(const auto& [name, tally]: s_tallies){
+        Entry entry{*name, {}};
+        std::copy(tally.counts, tally.counts + NEVENTS, entry.counts);
+        result.push_back(entry);
+    }
+    auto total = [](const Entry& entry){
+        std::uint64_t sum = 0;
+        for(auto count: entry.counts){
+            sum += count;
+        }
+        return sum;
+    };
+    std::sort(result.begin(), result.end(), [&total](const Entry& x, const Entry& y){
+        return total(x) > total(y);
+    });
+    return result;
+}
+
+// -*-
+void Accounting::print(std::ostream& out){
+    out << "------------------------------------------------------------------------------\n";
+    out << "          FUNCTION |";
+    for(size_t i=0; i < NEVENTS; i++){
+        out << " " << std::setw(13) << EVENT_NAMES[i] << (i+1 < NEVENTS ? " |" : "\n");
+    }
+    out << "------------------------------------------------------------------------------\n";
+    for(const auto& entry: Accounting::entries()){
+        out << " " << std::setw(17) << entry.name << " |";
+        for(size_t i=0; i < NEVENTS; i++){
+            out << " " << std::setw(13) << entry.counts[i] << (i+1 < NEVENTS ? " |" : "\n");
+        }
+    }
+    if(!s_enabled){
+        out << "(collection is off; ':allocs on' or (alloc-stats-enable) to start)\n";
+    }
+}
+
+// -*-------------------------------------------------------------------*-
+// -*- NodeProfile                                                     -*-
+// -*-------------------------------------------------------------------*-
+// The counts live on the nodes' inline caches; a node joins the registry
+// the first time it is counted, which is what lets a report find it.
+namespace{
+struct ProfiledNode{
+    std::shared_ptr<InlineCache> cache;
+    std::string name;
+    bool call;
+};
+
+std::vector<ProfiledNode> s_nodes;
+std::mutex s_nodes_lock;
+
+const char* PATH_NAMES[] = {
+    "-", "generic", "int +", "int -", "int *",
+    "int <", "int >", "int <=", "int >=", "int ="
+};
+}
+
+bool NodeProfile::s_enabled = false;
+
+// -*-
+void NodeProfile::enable(bool flag){
+    s_enabled = flag;
+}
+
+// -*-
+void NodeProfile::reset(){
+    std::lock_guard<std::mutex> lock(s_nodes_lock);
+    for(auto& node: s_nodes){
+        node.cache->count = 0;
+        node.cache->types = 0;
+    }
+    s_nodes.clear();
+}
+
+// -*-
+void NodeProfile::record(const std::shared_ptr<InlineCache>& node, const std::string& name, bool call, Type type){
+    if(node->count++ == 0){
+        std::lock_guard<std::mutex> lock(s_nodes_lock);
+        s_nodes.push_back(ProfiledNode{node, name, call});
+    }
+    node->types |= std::uint32_t(1) << static_cast<unsigned>(type);
+}
+
+// -*-
+std::vector<NodeProfile::Entry> NodeProfile::entries(){
+    std::lock_guard<std::mutex> lock(s_nodes_lock);
+    std::vector<Entry> result;
+    result.reserve(s_nodes.size());
+    for(const auto& node: s_nodes){
+        const InlineCache& cache = *node.cache;
+        Entry entry{
+            cache.span.known() ? cache.span.str() : "?",
+            node.call ? "(" + node.name + " ...)" : node.name,
+            cache.count, {}, node.call ? PATH_NAMES[cache.path] : ""
+        };
+        for(unsigned bit=0; bit < 32; bit++){
+            if(cache.types & (std::uint32_t(1) << bit)){
+                // integers and bignums share a name
+                const std::string& type = swzlispTypes[static_cast<Type>(bit)];
+                if(std::find(entry.types.begin(), entry.types.end(), type) == entry.types.end()){
+                    entry.types.push_back(type);
+                }
+            }
+        }
+        result.push_back(std::move(entry));
+    }
+    std::sort(result.begin(), result.end(), [](const Entry& x, const Entry& y){
+        return x.count > y.count;
+    });
+    return result;
+}
+
+// -*-
+void NodeProfile::print(std::ostream& out){
+    out << "------------------------------------------------------------------------------\n";
+    out << "             LOCATION |           NODE |      COUNT |          TYPES | PATH\n";
+    out << "------------------------------------------------------------------------------\n";
+    for(const auto& entry: NodeProfile::entries()){
+        std::string types;
+        for(const auto& type: entry.types){
+            types += (types.empty() ? "" : ",") + type;
+        }
+        out << " " << std::setw(20) << entry.location << " |";
+        out << " " << std::setw(14) << entry.node << " |";
+        out << " " << std::setw(10) << entry.count << " |";
+        out << " " << std::setw(14) << types << " |";
+        out << " " << entry.path << "\n";
+    }
+    if(!s_enabled){
+        out << "(collection is off; ':nodes on' or (node-profile-enable) to start)\n";
+    }
+}
+
+// -*-------------------------------------------------------------------*-
+// -*- Tracer                                                          -*-
+// -*-------------------------------------------------------------------*-
+// A ring is created the first time its thread records an event and is
+// kept in a registry for write_json(); recording itself takes no lock.
+namespace{
+constexpr size_t TRACE_CAPACITY = size_t(1) << 18;
+
+struct TraceEvent{
+    FrameName name;
+    const char* category;
+    std::uint64_t start;
+    std::uint64_t duration;
+    Span span;
+};
+
+struct TraceRing{
+    std::vector<TraceEvent> events;
+    size_t written = 0;                 // including those overwritten
+    unsigned tid = 0;
+};
+
+std::mutex s_rings_lock;
+std::vector<std::shared_ptr<TraceRing>> s_rings;
+std::uint64_t s_origin = 0;
+
+TraceRing& local_ring(){
+    thread_local std::shared_ptr<TraceRing> ring;
+    if(ring == nullptr){
+        ring = std::make_shared<TraceRing>();
+        ring->events.resize(TRACE_CAPACITY);
+        std::lock_guard<std::mutex> lock(s_rings_lock);
+        ring->tid = static_cast<unsigned>(s_rings.size() + 1);
+        s_rings.push_back(ring);
+    }
+    return *ring;
+}
+
+void write_escaped(std::ostream& out, const std::string& text){
+    out << '"';
+    for(char c: text){
+        if(c == '"' || c == '\\'){
+            out << '\\' << c;
+        }else if(static_cast<unsigned char>(c) < 0x20){
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                << static_cast<int>(c) << std::dec << std::setfill(' ');
+        }else{
+            out << c;
+        }
+    }
+    out << '"';
+}
+}
+
+bool Tracer::s_enabled = false;
+std::uint64_t Tracer::s_threshold = 0;
+
+// -*-
+void Tracer::start(double threshold_us){
+    if(threshold_us < 0){
+        throw Error(ErrorKind::ValueError, "tracer: threshold must not be negative");
+    }
+    {
+        std::lock_guard<std::mutex> lock(s_rings_lock);
+        for(auto& ring: s_rings){
+            ring->written = 0;
+        }
+    }
+    local_ring();                       // allocate now, not mid-trace
+    s_threshold = static_cast<std::uint64_t>(threshold_us * 1e3);
+    s_origin = Tracer::now();
+    s_enabled = true;
+}
+
+// -*-
+void Tracer::stop(){
+    s_enabled = false;
+}
+
+// -*-
+std::uint64_t Tracer::now(){
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count());
+}
+
+// -*-
+void Tracer::record(
+    FrameName name, const char* category,
+    std::uint64_t start, std::uint64_t end, const Span& span)
+{
+    TraceRing& ring = local_ring();
+    start = std::max(start, s_origin);  // began before a restart
+    ring.events[ring.written % TRACE_CAPACITY] = TraceEvent{name, category, start, end - start, span};
+    ring.written++;
+}
+
+// -*-
+size_t Tracer::events(){
+    std::lock_guard<std::mutex> lock(s_rings_lock);
+    size_t result = 0;
+    for(const auto& ring: s_rings){
+        result += std::min(ring->written, TRACE_CAPACITY);
+    }
+    return result;
+}
+
+// -*-
+size_t Tracer::dropped(){
+    std::lock_guard<std::mutex> lock(s_rings_lock);
+    size_t result = 0;
+    for(const auto& ring: s_rings){
+        result += ring->written - std::min(ring->written, TRACE_CAPACITY);
+    }
+    return result;
+}
+
+// -*-
+// Complete ("X") events in microseconds since start(), oldest first per
+// thread; a span, when known, goes into the event's args.
+void Tracer::write_json(std::ostream& out){
+    std::lock_guard<std::mutex> lock(s_rings_lock);
+    auto flags = out.flags();
+    auto precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for(const auto& ring: s_rings){
+        size_t count = std::min(ring->written, TRACE_CAPACITY);
+        for(size_t i=ring->written - count; i < ring->written; i++){
+            const TraceEvent& event = ring->events[i % TRACE_CAPACITY];
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "{\"name\":";
+            write_escaped(out, *event.name);
+            out << ",\"cat\":\"" << event.category << "\",\"ph\":\"X\"";
+            out << ",\"ts\":" << (event.start - s_origin)*1e-3;
+            out << ",\"dur\":" << event.duration*1e-3;
+            out << ",\"pid\":1,\"tid\":" << ring->tid;
+            if(event.span.known()){
+                out << ",\"args\":{\"location\":";
+                write_escaped(out, event.span.str());
+                out << "}";
+            }
+            out << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+// -*-------------------------------------------------------------------*-
+}//-*- end::namespace::swzlisp                                         -*-
+// -*-------------------------------------------------------------------*-
@@ -0,0 +1,192 @@
+#include "swzlisp.hpp"
+
+// -*-------------------------------------------------------------------*-
+// -*- namespace::swzlisp                                              -*-
+// -*-------------------------------------------------------------------*-
+namespace swzlisp{
+// -*-------------------------------------------------------------------*-
+// -*- Sequence                                                        -*-
+// -*-------------------------------------------------------------------*-
+size_t Sequence::size() const{
+    size_t result = 0;
+    Object item;
+    auto iter = this->iterate();
+    while(iter->next(item)){
+        result++;
+    }
+    return result;
+}
+
+namespace{
+// -*-
+// start, start+step, ... up to but excluding stop; step may be negative.
+class Range: public Sequence{
+public:
+    Range(long start, long stop, long step)
+    : m_start{start}, m_stop{stop}, m_step{step}{}
+
+    class Cursor: public Iterator{
+    public:
+        explicit Cursor(const Range& range)
+        : m_value{range.m_start}, m_left{range.size()}, m_step{range.m_step}{}
+
+        bool next(Object& out) override{
+            if(this->m_left == 0){
+                return false;
+            }
+            out = Object(this->m_value);
+            // wraps harmlessly past the last element instead of overflowing
+            this->m_value = static_cast<long>(
+                static_cast<unsigned long>(this->m_value) + static_cast<unsigned long>(this->m_step)
+            );
+            this->m_left--;
+            return true;
+        }
+
+    private:
+        long m_value;
+        size_t m_left;
+        long m_step;
+    };
+
+    std::unique_ptr<Iterator> iterate() const override{
+        return std::make_unique<Cursor>(*this);
+    }
+
+    size_t size() const override{
+        if(this->m_step > 0 && this->m_start < this->m_stop){
+            return static_cast<size_t>(
+                (static_cast<unsigned long>(this->m_stop) - this->m_start - 1) / this->m_step + 1
+            );
+        }
+        if(this->m_step < 0 && this->m_start > this->m_stop){
+            return static_cast<size_t>(
+                (static_cast<unsigned long>(this->m_start) - this->m_stop - 1) /
+                (0UL - static_cast<unsigned long>(this->m_step)) + 1
+            );
+        }
+        return 0;
+    }
+
+    std::string repr() const override{
+        std::ostringstream stream;
+        stream << "(range " << this->m_start << " " << this->m_stop << " " << this->m_step << ")";
+        return stream.str();
+    }
+
+private:
+    long m_start;
+    long m_stop;
+    long m_step;
+};
+
+// -*-
+// count points start + i*(stop-start)/count for i in [0, count)
+class Linspace: public Sequence{
+public:
+    Linspace(double start, double stop, size_t count)
+    : m_start{start}, m_stop{stop}, m_count{count}{}
+
+    class Cursor: public Iterator{
+    public:
+        explicit Cursor(const Linspace& space)
+        : m_start{space.m_start}, m_dx{(space.m_stop - space.m_start)/space.m_count},
+          m_count{space.m_count}, m_index{0}{}
+
+        bool next(Object& out) override{
+            if(this->m_index >= this->m_count){
+                return false;
+            }
+            out = Object(this->m_start + this->m_index * this->m_dx);
+            this->m_index++;
+            return true;
+        }
+
+    private:
+        double m_start;
+        double m_dx;
+        size_t m_count;
+        size_t m_index;
+    };
+
+    std::unique_ptr<Iterator> iterate() const override{
+        return std::make_unique<Cursor>(*this);
+    }
+
+    size_t size() const override{
+        return this->m_count;
+    }
+
+    std::string repr() const override{
+        std::ostringstream stream;
+        stream << "(linspace " << this->m_start << " " << this->m_stop << " " << this->m_count << ")";
+        return stream.str();
+    }
+
+private:
+    double m_start;
+    double m_stop;
+    size_t m_count;
+};
+
+// -*-
+// Lines of a text file, read one at a time; each walk reopens the file.
+class Lines: public Sequence{
+public:
+    explicit Lines(const std::string& filename): m_filename{filename}{}
+
+    class Cursor: public Iterator{
+    public:
+        explicit Cursor(const std::string& filename): m_stream{filename}{
+            if(!this->m_stream.is_open()){
+                throw Error(Env(), ("could not open file '" + filename + "'").c_str());
+            }
+        }
+
+        bool next(Object& out) override{
+            std::string line;
+            if(!std::getline(this->m_stream, line)){
+                return false;
+            }
+            out = Object::create_string(std::move(line));
+            return true;
+        }
+
+    private:
+        std::ifstream m_stream;
+    };
+
+    std::unique_ptr<Iterator> iterate() const override{
+        return std::make_unique<Cursor>(this->m_filename);
+    }
+
+    std::string repr() const override{
+        return "(read-lines \"" + this->m_filename + "\")";
+    }
+
+private:
+    std::string m_filename;
+};
+}
+
+// -*-
+std::shared_ptr<const Sequence> Sequence::range(long start, long stop, long step){
+    if(step == 0){
+        throw Error(Env(), "range: step must not be zero");
+    }
+    return std::make_shared<const Range>(start, stop, step);
+}
+
+// -*-
+std::shared_ptr<const Sequence> Sequence::linspace(double start, double stop, size_t count){
+    return std::make_shared<const Linspace>(start, stop, count);
+}
+
+// -*-
+std::shared_ptr<const Sequence> Sequence::lines(const std::string& filename){
+    return std::make_shared<const Lines>(filename);
+}
+
+// -*-------------------------------------------------------------------*-
+}//-*- end::namespace::swzlisp                                         -*-
+// -*-------------------------------------------------------------------*-
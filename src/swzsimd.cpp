@@ -0,0 +1,418 @@
+#include "swzlisp.hpp"
+#include<algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include<immintrin.h>
+#define SWZLISP_X86 1
+#define SWZLISP_AVX2 __attribute__((target("avx2")))
+#endif
+
+// -*-------------------------------------------------------------------*-
+// -*- namespace::swzlisp::simd                                        -*-
+// -*-------------------------------------------------------------------*-
+namespace swzlisp{
+namespace simd{
+// -*-
+bool has_avx2(){
+#ifdef SWZLISP_X86
+    static const bool result = __builtin_cpu_supports("avx2");
+    return result;
+#else
+    return false;
+#endif
+}
+
+namespace{
+// -*-
+// Scalar bodies; also used for the tails of the vector loops.
+template<typename T>
+T scalar(Op op, T x, T y){
+    switch(op){
+    case Op::Add: return x + y;
+    case Op::Sub: return x - y;
+    case Op::Mul: return x * y;
+    case Op::Div: return x / y;
+    }
+    return T();
+}
+
+// -*-
+// Integers wrap, as the AVX2 kernels do: the arithmetic runs on unsigned
+// values, and LONG_MIN / -1 gives LONG_MIN instead of trapping.
+template<>
+long scalar(Op op, long x, long y){
+    auto a = static_cast<unsigned long>(x);
+    auto b = static_cast<unsigned long>(y);
+    switch(op){
+    case Op::Add: return static_cast<long>(a + b);
+    case Op::Sub: return static_cast<long>(a - b);
+    case Op::Mul: return static_cast<long>(a * b);
+    case Op::Div: return y == -1 ? static_cast<long>(0ul - a) : x / y;
+    }
+    return 0;
+}
+
+// -*-
+template<typename T>
+long scalar(Cmp cmp, T x, T y){
+    switch(cmp){
+    case Cmp::Eq: return x == y;
+    case Cmp::Ne: return x != y;
+    case Cmp::Lt: return x < y;
+    case Cmp::Gt: return x > y;
+    case Cmp::Le: return x <= y;
+    case Cmp::Ge: return x >= y;
+    }
+    return 0;
+}
+
+// -*-
+template<typename T>
+void binary_scalar(Op op, const T* x, bool xs, const T* y, bool ys, T* z, size_t n){
+    for(size_t i=0; i < n; i++){
+        z[i] = scalar(op, xs ? x[0] : x[i], ys ? y[0] : y[i]);
+    }
+}
+
+// -*-
+template<typename T>
+void compare_scalar(Cmp cmp, const T* x, bool xs, const T* y, bool ys, long* z, size_t n){
+    for(size_t i=0; i < n; i++){
+        z[i] = scalar(cmp, xs ? x[0] : x[i], ys ? y[0] : y[i]);
+    }
+}
+
+#ifdef SWZLISP_X86
+// -*-
+template<Op op>
+SWZLISP_AVX2 __m256d packed(__m256d x, __m256d y){
+    switch(op){
+    case Op::Add: return _mm256_add_pd(x, y);
+    case Op::Sub: return _mm256_sub_pd(x, y);
+    case Op::Mul: return _mm256_mul_pd(x, y);
+    case Op::Div: return _mm256_div_pd(x, y);
+    }
+    return x;
+}
+
+// -*-
+template<Op op>
+SWZLISP_AVX2 void f64_binary(const double* x, bool xs, const double* y, bool ys, double* z, size_t n){
+    size_t i = 0;
+    __m256d bx = _mm256_set1_pd(x[0]);
+    __m256d by = _mm256_set1_pd(y[0]);
+    for(; i + 4 <= n; i += 4){
+        __m256d a = xs ? bx : _mm256_loadu_pd(x + i);
+        __m256d b = ys ? by : _mm256_loadu_pd(y + i);
+        _mm256_storeu_pd(z + i, packed<op>(a, b));
+    }
+    for(; i < n; i++){
+        z[i] = scalar(op, xs ? x[0] : x[i], ys ? y[0] : y[i]);
+    }
+}
+
+// -*-
+// Only add and sub have 64-bit lanes in AVX2; mul and div stay scalar.
+template<Op op>
+SWZLISP_AVX2 void i64_binary(const long* x, bool xs, const long* y, bool ys, long* z, size_t n){
+    size_t i = 0;
+    __m256i bx = _mm256_set1_epi64x(x[0]);
+    __m256i by = _mm256_set1_epi64x(y[0]);
+    for(; i + 4 <= n; i += 4){
+        __m256i a = xs ? bx : _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+        __m256i b = ys ? by : _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+        __m256i c = (op == Op::Add) ? _mm256_add_epi64(a, b) : _mm256_sub_epi64(a, b);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(z + i), c);
+    }
+    for(; i < n; i++){
+        z[i] = scalar(op, xs ? x[0] : x[i], ys ? y[0] : y[i]);
+    }
+}
+
+// -*-
+template<int predicate>
+SWZLISP_AVX2 void f64_compare(Cmp cmp, const double* x, bool xs, const double* y, bool ys, long* z, size_t n){
+    size_t i = 0;
+    __m256d bx = _mm256_set1_pd(x[0]);
+    __m256d by = _mm256_set1_pd(y[0]);
+    __m256i one = _mm256_set1_epi64x(1);
+    for(; i + 4 <= n; i += 4){
+        __m256d a = xs ? bx : _mm256_loadu_pd(x + i);
+        __m256d b = ys ? by : _mm256_loadu_pd(y + i);
+        __m256i mask = _mm256_castpd_si256(_mm256_cmp_pd(a, b, predicate));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(z + i), _mm256_and_si256(mask, one));
+    }
+    for(; i < n; i++){
+        z[i] = scalar(cmp, xs ? x[0] : x[i], ys ? y[0] : y[i]);
+    }
+}
+
+// -*-
+// AVX2 only has == and > on 64-bit lanes: the rest are swaps/negations.
+SWZLISP_AVX2 void i64_compare(Cmp cmp, const long* x, bool xs, const long* y, bool ys, long* z, size_t n){
+    size_t i = 0;
+    __m256i bx = _mm256_set1_epi64x(x[0]);
+    __m256i by = _mm256_set1_epi64x(y[0]);
+    __m256i one = _mm256_set1_epi64x(1);
+    for(; i + 4 <= n; i += 4){
+        __m256i a = xs ? bx : _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+        __m256i b = ys ? by : _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+        __m256i mask;
+        bool negate = false;
+        switch(cmp){
+        case Cmp::Eq: mask = _mm256_cmpeq_epi64(a, b); break;
+        case Cmp::Ne: mask = _mm256_cmpeq_epi64(a, b); negate = true; break;
+        case Cmp::Gt: mask = _mm256_cmpgt_epi64(a, b); break;
+        case Cmp::Lt: mask = _mm256_cmpgt_epi64(b, a); break;
+        case Cmp::Le: mask = _mm256_cmpgt_epi64(a, b); negate = true; break;
+        case Cmp::Ge: mask = _mm256_cmpgt_epi64(b, a); negate = true; break;
+        default: mask = _mm256_setzero_si256(); break;
+        }
+        __m256i c = negate ? _mm256_andnot_si256(mask, one) : _mm256_and_si256(mask, one);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(z + i), c);
+    }
+    for(; i < n; i++){
+        z[i] = scalar(cmp, xs ? x[0] : x[i], ys ? y[0] : y[i]);
+    }
+}
+
+// -*-
+SWZLISP_AVX2 double hsum(__m256d x){
+    __m128d lo = _mm256_castpd256_pd128(x);
+    __m128d hi = _mm256_extractf128_pd(x, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(lo) + _mm_cvtsd_f64(_mm_unpackhi_pd(lo, lo));
+}
+
+// -*-
+SWZLISP_AVX2 double f64_sum(const double* x, size_t n){
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(x + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(x + i + 4));
+    }
+    double result = hsum(_mm256_add_pd(acc0, acc1));
+    for(; i < n; i++){ result += x[i]; }
+    return result;
+}
+
+// -*-
+SWZLISP_AVX2 double f64_dot(const double* x, const double* y, size_t n){
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+    }
+    double result = hsum(_mm256_add_pd(acc0, acc1));
+    for(; i < n; i++){ result += x[i] * y[i]; }
+    return result;
+}
+
+// -*-
+template<bool lowest>
+SWZLISP_AVX2 double f64_extremum(const double* x, size_t n){
+    size_t i = 4;
+    __m256d acc = _mm256_loadu_pd(x);
+    for(; i + 4 <= n; i += 4){
+        __m256d a = _mm256_loadu_pd(x + i);
+        acc = lowest ? _mm256_min_pd(acc, a) : _mm256_max_pd(acc, a);
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    double result = lanes[0];
+    for(size_t k=1; k < 4; k++){
+        result = lowest ? std::min(result, lanes[k]) : std::max(result, lanes[k]);
+    }
+    for(; i < n; i++){
+        result = lowest ? std::min(result, x[i]) : std::max(result, x[i]);
+    }
+    return result;
+}
+
+// -*-
+SWZLISP_AVX2 long i64_sum(const long* x, size_t n){
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        acc = _mm256_add_epi64(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)));
+    }
+    long lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    // wraps like the packed adds: accumulate unsigned
+    unsigned long result = 0;
+    for(auto lane: lanes){ result += static_cast<unsigned long>(lane); }
+    for(; i < n; i++){ result += static_cast<unsigned long>(x[i]); }
+    return static_cast<long>(result);
+}
+
+// -*-
+template<bool lowest>
+SWZLISP_AVX2 long i64_extremum(const long* x, size_t n){
+    size_t i = 4;
+    __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x));
+    for(; i + 4 <= n; i += 4){
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+        __m256i gt = _mm256_cmpgt_epi64(acc, a);
+        acc = lowest ? _mm256_blendv_epi8(acc, a, gt) : _mm256_blendv_epi8(a, acc, gt);
+    }
+    long lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    long result = lanes[0];
+    for(size_t k=1; k < 4; k++){
+        result = lowest ? std::min(result, lanes[k]) : std::max(result, lanes[k]);
+    }
+    for(; i < n; i++){
+        result = lowest ? std::min(result, x[i]) : std::max(result, x[i]);
+    }
+    return result;
+}
+#endif
+}
+
+// -*-
+void binary(Op op, const double* x, bool xs, const double* y, bool ys, double* z, size_t n){
+    if(n == 0){ return; }
+#ifdef SWZLISP_X86
+    if(has_avx2()){
+        switch(op){
+        case Op::Add: f64_binary<Op::Add>(x, xs, y, ys, z, n); return;
+        case Op::Sub: f64_binary<Op::Sub>(x, xs, y, ys, z, n); return;
+        case Op::Mul: f64_binary<Op::Mul>(x, xs, y, ys, z, n); return;
+        case Op::Div: f64_binary<Op::Div>(x, xs, y, ys, z, n); return;
+        }
+    }
+#endif
+    binary_scalar(op, x, xs, y, ys, z, n);
+}
+
+// -*-
+void binary(Op op, const long* x, bool xs, const long* y, bool ys, long* z, size_t n){
+    if(n == 0){ return; }
+    if(op == Op::Div){
+        for(size_t i=0; i < (ys ? 1 : n); i++){
+            if(y[i] == 0){ throw Error(Env(), ErrorKind::ZeroDivisionError); }
+        }
+    }
+#ifdef SWZLISP_X86
+    if(has_avx2() && (op == Op::Add || op == Op::Sub)){
+        if(op == Op::Add){
+            i64_binary<Op::Add>(x, xs, y, ys, z, n);
+        }else{
+            i64_binary<Op::Sub>(x, xs, y, ys, z, n);
+        }
+        return;
+    }
+#endif
+    binary_scalar(op, x, xs, y, ys, z, n);
+}
+
+// -*-
+void compare(Cmp cmp, const double* x, bool xs, const double* y, bool ys, long* z, size_t n){
+    if(n == 0){ return; }
+#ifdef SWZLISP_X86
+    if(has_avx2()){
+        switch(cmp){
+        case Cmp::Eq: f64_compare<_CMP_EQ_OQ>(cmp, x, xs, y, ys, z, n); return;
+        case Cmp::Ne: f64_compare<_CMP_NEQ_UQ>(cmp, x, xs, y, ys, z, n); return;
+        case Cmp::Lt: f64_compare<_CMP_LT_OQ>(cmp, x, xs, y, ys, z, n); return;
+        case Cmp::Gt: f64_compare<_CMP_GT_OQ>(cmp, x, xs, y, ys, z, n); return;
+        case Cmp::Le: f64_compare<_CMP_LE_OQ>(cmp, x, xs, y, ys, z, n); return;
+        case Cmp::Ge: f64_compare<_CMP_GE_OQ>(cmp, x, xs, y, ys, z, n); return;
+        }
+    }
+#endif
+    compare_scalar(cmp, x, xs, y, ys, z, n);
+}
+
+// -*-
+void compare(Cmp cmp, const long* x, bool xs, const long* y, bool ys, long* z, size_t n){
+    if(n == 0){ return; }
+#ifdef SWZLISP_X86
+    if(has_avx2()){
+        i64_compare(cmp, x, xs, y, ys, z, n);
+        return;
+    }
+#endif
+    compare_scalar(cmp, x, xs, y, ys, z, n);
+}
+
+// -*-
+double sum(const double* x, size_t n){
+#ifdef SWZLISP_X86
+    if(has_avx2()){ return f64_sum(x, n); }
+#endif
+    double result = 0.0;
+    for(size_t i=0; i < n; i++){ result += x[i]; }
+    return result;
+}
+
+// -*-
+long sum(const long* x, size_t n){
+#ifdef SWZLISP_X86
+    if(has_avx2()){ return i64_sum(x, n); }
+#endif
+    unsigned long result = 0;
+    for(size_t i=0; i < n; i++){ result += static_cast<unsigned long>(x[i]); }
+    return static_cast<long>(result);
+}
+
+// -*-
+double dot(const double* x, const double* y, size_t n){
+#ifdef SWZLISP_X86
+    if(has_avx2()){ return f64_dot(x, y, n); }
+#endif
+    double result = 0.0;
+    for(size_t i=0; i < n; i++){ result += x[i] * y[i]; }
+    return result;
+}
+
+// -*-
+long dot(const long* x, const long* y, size_t n){
+    unsigned long result = 0;
+    for(size_t i=0; i < n; i++){
+        result += static_cast<unsigned long>(x[i]) * static_cast<unsigned long>(y[i]);
+    }
+    return static_cast<long>(result);
+}
+
+// -*-
+// min/max expect n > 0
+double min(const double* x, size_t n){
+#ifdef SWZLISP_X86
+    if(has_avx2() && n >= 4){ return f64_extremum<true>(x, n); }
+#endif
+    return *std::min_element(x, x + n);
+}
+
+// -*-
+double max(const double* x, size_t n){
+#ifdef SWZLISP_X86
+    if(has_avx2() && n >= 4){ return f64_extremum<false>(x, n); }
+#endif
+    return *std::max_element(x, x + n);
+}
+
+// -*-
+long min(const long* x, size_t n){
+#ifdef SWZLISP_X86
+    if(has_avx2() && n >= 4){ return i64_extremum<true>(x, n); }
+#endif
+    return *std::min_element(x, x + n);
+}
+
+// -*-
+long max(const long* x, size_t n){
+#ifdef SWZLISP_X86
+    if(has_avx2() && n >= 4){ return i64_extremum<false>(x, n); }
+#endif
+    return *std::max_element(x, x + n);
+}
+
+// -*-------------------------------------------------------------------*-
+}//-*- end::namespace::swzlisp::simd                                   -*-
+}
+// -*-------------------------------------------------------------------*-
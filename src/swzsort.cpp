@@ -0,0 +1,149 @@
+#include "swzlisp.hpp"
+#include<algorithm>
+#include<numeric>
+#include<future>
+#include<thread>
+
+// -*-------------------------------------------------------------------*-
+// -*- namespace::swzlisp::sorting                                     -*-
+// -*-------------------------------------------------------------------*-
+namespace swzlisp{
+namespace sorting{
+namespace{
+// below this many elements a single std::sort (introsort) wins
+constexpr size_t PARALLEL_THRESHOLD = size_t(1) << 16;
+
+// -*-
+// Number of runs for n elements: a power of two so that runs merge
+// pairwise, at most one per core, and each at least half the threshold.
+size_t runs_for(size_t n){
+    if(n < PARALLEL_THRESHOLD){
+        return 1;
+    }
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    size_t result = 1;
+    while(result*2 <= cores && result*PARALLEL_THRESHOLD <= n){
+        result *= 2;
+    }
+    return result;
+}
+
+// -*-
+// less must not throw and must not touch interpreter state: it runs on
+// worker threads.
+template<typename Iter, typename Less>
+void parallel_sort(Iter first, Iter last, Less less){
+    size_t n = static_cast<size_t>(last - first);
+    size_t runs = runs_for(n);
+    if(runs <= 1){
+        std::sort(first, last, less);
+        return;
+    }
+    std::vector<Iter> bounds(runs + 1);
+    for(size_t i=0; i <= runs; i++){
+        bounds[i] = first + n*i/runs;
+    }
+
+    std::vector<std::future<void>> tasks;
+    for(size_t i=0; i < runs; i++){
+        Iter lo = bounds[i];
+        Iter hi = bounds[i+1];
+        tasks.push_back(std::async(std::launch::async, [lo, hi, less]{
+            std::sort(lo, hi, less);
+        }));
+    }
+    for(auto& task: tasks){
+        task.get();
+    }
+
+    for(size_t width=1; width < runs; width *= 2){
+        tasks.clear();
+        for(size_t i=0; i + width < runs; i += 2*width){
+            Iter lo = bounds[i];
+            Iter mid = bounds[i+width];
+            Iter hi = bounds[std::min(i + 2*width, runs)];
+            tasks.push_back(std::async(std::launch::async, [lo, mid, hi, less]{
+                std::inplace_merge(lo, mid, hi, less);
+            }));
+        }
+        for(auto& task: tasks){
+            task.get();
+        }
+    }
+}
+
+// -*-
+// True when compare cannot throw on any pair of these values: all numbers,
+// all strings or all atoms.
+bool comparable(const std::vector<Object>& items){
+    if(items.empty()){
+        return true;
+    }
+    if(items[0].is_number()){
+        return std::all_of(items.begin(), items.end(), [](const Object& item){
+            return item.is_number();
+        });
+    }
+    Type type = items[0].type();
+    if(type != Type::String && type != Type::Atom){
+        return false;
+    }
+    return std::all_of(items.begin(), items.end(), [type](const Object& item){
+        return item.type() == type;
+    });
+}
+}
+
+// -*-
+void sort(std::vector<double>& data){
+    parallel_sort(data.begin(), data.end(), [](double x, double y){
+        return x < y || (std::isnan(y) && !std::isnan(x));
+    });
+}
+
+// -*-
+void sort(std::vector<long>& data){
+    parallel_sort(data.begin(), data.end(), std::less<long>());
+}
+
+// -*-
+void sort(std::vector<Object>& items){
+    auto less = [](const Object& x, const Object& y){
+        return x.compare(y) < 0;
+    };
+    if(comparable(items)){
+        parallel_sort(items.begin(), items.end(), less);
+    }else{
+        // may throw a TypeError part way, so stay on this thread
+        std::sort(items.begin(), items.end(), less);
+    }
+}
+
+// -*-
+// Decorate-sort-undecorate: positions are sorted by key, ties broken by
+// position, and the items are then gathered in that order.
+void sort_by(std::vector<Object>& items, const std::vector<Object>& keys){
+    std::vector<size_t> order(items.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto less = [&keys](size_t i, size_t j){
+        int cmp = keys[i].compare(keys[j]);
+        return cmp < 0 || (cmp == 0 && i < j);
+    };
+    if(comparable(keys)){
+        parallel_sort(order.begin(), order.end(), less);
+    }else{
+        std::sort(order.begin(), order.end(), less);
+    }
+
+    std::vector<Object> result;
+    result.reserve(items.size());
+    for(auto i: order){
+        result.push_back(std::move(items[i]));
+    }
+    items = std::move(result);
+}
+
+// -*-------------------------------------------------------------------*-
+}//-*- end::namespace::swzlisp::sorting                                -*-
+}//-*- end::namespace::swzlisp                                         -*-
+// -*-------------------------------------------------------------------*-